@@ -8,12 +8,18 @@ let package = Package(
     products: [
         .library(name: "SwiftQuantis", targets: ["SwiftQuantis"]),
         .executable(name:"SwiftQuantisCLI", targets: ["SwiftQuantisCLI"]),
+        .executable(name:"SwiftQuantisBenchmark", targets: ["SwiftQuantisBenchmark"]),
+        .executable(name:"QuantisDaemon", targets: ["QuantisDaemon"]),
     ],
     dependencies: [
         .package(url: "https://github.com/apple/swift-argument-parser", from: "1.1.0"),
     ],
     targets: [
-        .target(name: "СQuantis", path: "./Sources/СQuantis"),
+        .target(name: "СQuantis", path: "./Sources/СQuantis", linkerSettings: [
+            .linkedLibrary("pthread", .when(platforms: [.linux])),
+            .linkedLibrary("m", .when(platforms: [.linux])),
+            .linkedLibrary("rt", .when(platforms: [.linux])),
+        ]),
         .target(name: "SwiftQuantis", dependencies: [
             "СQuantis",
             "CLibUSB",
@@ -24,6 +30,16 @@ let package = Package(
             "CLibUSB",
             .product(name: "ArgumentParser", package: "swift-argument-parser"),
         ]),
+        .executableTarget(name: "SwiftQuantisBenchmark", dependencies: [
+            "СQuantis",
+            "SwiftQuantis",
+            "CLibUSB",
+            .product(name: "ArgumentParser", package: "swift-argument-parser"),
+        ]),
+        .executableTarget(name: "QuantisDaemon", dependencies: [
+            "СQuantis",
+            "CLibUSB",
+        ]),
         .systemLibrary(
             name: "CLibUSB",
             pkgConfig: "libusb-1.0",
@@ -0,0 +1,750 @@
+/*
+ * Quantis daemon
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+/*
+ * Serves random data of a Quantis device to many local processes over a
+ * Unix domain socket, so that they share one open device and its prefetch
+ * buffer instead of each claiming the device. See QuantisDaemonRequest for
+ * the protocol, and QuantisDaemonConnect for the client side.
+ *
+ * The complete requests received from all the clients are served by a
+ * single device read per iteration of the event loop. A read is at most
+ * QUANTISD_BATCH_SIZE bytes: larger requests are served over several
+ * iterations, and every iteration starts with another client, so that a
+ * large request never holds the small requests of the other clients back.
+ *
+ * With -m, the daemon publishes a shared memory ring (see QuantisShmCreate)
+ * instead, for clients that cannot afford a socket round-trip.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Quantis.h"
+
+/* Largest number of clients connected at the same time */
+#define QUANTISD_MAX_CLIENTS 1024u
+
+/* Requests received and not served yet are kept up to this number */
+#define QUANTISD_INPUT_REQUESTS 64u
+
+/* The requests of a client are not served while it has more pending output */
+#define QUANTISD_MAX_PENDING_OUTPUT (32u * 1024u * 1024u)
+
+/* Largest number of bytes read from the device per iteration of the event loop */
+#define QUANTISD_BATCH_SIZE (256u * 1024u)
+
+/* Default size of the prefetch buffer of the device */
+#define QUANTISD_DEFAULT_PREFETCH_SIZE QUANTIS_MAX_READ_SIZE
+
+typedef struct QuantisdClient
+{
+  int socket;
+  int closed;
+
+  /* Requests received, possibly ending with a partial one */
+  unsigned char input[QUANTISD_INPUT_REQUESTS * sizeof(QuantisDaemonRequest)];
+  size_t inputSize;
+
+  /* Responses not sent yet */
+  unsigned char *output;
+  size_t outputSize;
+  size_t outputPosition;
+  size_t outputCapacity;
+
+  /* Bytes of the first request already sent, its response being sent in parts */
+  size_t requestServed;
+
+  /*
+   * Number of requests completed by the current batch, and bytes of the
+   * following request served by it without completing it.
+   */
+  size_t batchCount;
+  size_t batchPartial;
+} QuantisdClient;
+
+static volatile sig_atomic_t running = 1;
+
+static void QuantisdStop(int signalNumber)
+{
+  (void)signalNumber;
+  running = 0;
+}
+
+static size_t QuantisdPendingOutput(const QuantisdClient *client)
+{
+  return client->outputSize - client->outputPosition;
+}
+
+/* Appends bytes to the output of the client */
+static void QuantisdAppend(QuantisdClient *client, const void *data, size_t size)
+{
+  if (client->closed || (size == 0u))
+  {
+    return;
+  }
+
+  if (client->outputPosition == client->outputSize)
+  {
+    client->outputPosition = 0u;
+    client->outputSize = 0u;
+  }
+
+  if (client->outputSize + size > client->outputCapacity)
+  {
+    size_t capacity = (client->outputCapacity > 0u) ? client->outputCapacity : 4096u;
+    unsigned char *output;
+
+    /* Drops the data already sent before growing the buffer */
+    memmove(client->output, client->output + client->outputPosition, QuantisdPendingOutput(client));
+    client->outputSize -= client->outputPosition;
+    client->outputPosition = 0u;
+
+    while (client->outputSize + size > capacity)
+    {
+      capacity *= 2u;
+    }
+    output = (unsigned char *)realloc(client->output, capacity);
+    if (output == NULL)
+    {
+      client->closed = 1;
+      return;
+    }
+    client->output = output;
+    client->outputCapacity = capacity;
+  }
+
+  memcpy(client->output + client->outputSize, data, size);
+  client->outputSize += size;
+}
+
+/* Appends a response and its data to the output of the client */
+static void QuantisdAppendResponse(QuantisdClient *client, int result, const void *data, size_t size)
+{
+  QuantisDaemonResponse response;
+
+  response.result = result;
+  QuantisdAppend(client, &response, sizeof(response));
+  QuantisdAppend(client, data, size);
+}
+
+/* Sends as much pending output as the socket accepts */
+static void QuantisdFlush(QuantisdClient *client)
+{
+  while (!client->closed && (QuantisdPendingOutput(client) > 0u))
+  {
+    ssize_t sent = send(client->socket,
+                        client->output + client->outputPosition,
+                        QuantisdPendingOutput(client),
+                        0);
+    if (sent < 0)
+    {
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+      {
+        client->closed = 1;
+      }
+      return;
+    }
+    client->outputPosition += (size_t)sent;
+  }
+}
+
+/* Receives requests until the input is full or the socket is empty */
+static void QuantisdReceive(QuantisdClient *client)
+{
+  while (client->inputSize < sizeof(client->input))
+  {
+    ssize_t received = recv(client->socket,
+                            client->input + client->inputSize,
+                            sizeof(client->input) - client->inputSize,
+                            0);
+    if (received < 0)
+    {
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+      {
+        client->closed = 1;
+      }
+      return;
+    }
+    else if (received == 0)
+    {
+      client->closed = 1;
+      return;
+    }
+    client->inputSize += (size_t)received;
+  }
+}
+
+/* Returns the size requested by a valid request, or a QUANTIS_ERROR code */
+static long QuantisdRequestSize(const QuantisDaemonRequest *request)
+{
+  if (request->opcode != QUANTIS_DAEMON_OPCODE_READ)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  if (request->size > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+  return (long)request->size;
+}
+
+/* Returns the request of index in the input of the client */
+static QuantisDaemonRequest QuantisdGetRequest(const QuantisdClient *client, size_t index)
+{
+  QuantisDaemonRequest request;
+  memcpy(&request, client->input + index * sizeof(request), sizeof(request));
+  return request;
+}
+
+/* Returns the number of bytes of the request of index not sent yet */
+static size_t QuantisdMissingSize(const QuantisdClient *client, size_t index)
+{
+  QuantisDaemonRequest request = QuantisdGetRequest(client, index);
+  long size = QuantisdRequestSize(&request);
+
+  if (size < 0)
+  {
+    /* Only an error is sent */
+    return 0u;
+  }
+
+  return (size_t)size - ((index == 0u) ? client->requestServed : 0u);
+}
+
+/*
+ * Serves the complete requests of the clients with a single device read of
+ * at most QUANTISD_BATCH_SIZE bytes, starting with client firstClient. The
+ * response to a request is sent in parts when it does not fit in the batch.
+ */
+static void QuantisdServe(QuantisDeviceHandle *deviceHandle,
+                          QuantisdClient *clients,
+                          size_t clientsCount,
+                          size_t firstClient,
+                          unsigned char *batch)
+{
+  size_t total = 0u;
+  size_t offset = 0u;
+  int served = 0;
+  int result = 0;
+  size_t k;
+
+  /*
+   * Takes the requests of each client in order, as long as they fit in the
+   * batch: small requests are never held back by a large one.
+   */
+  for (k = 0u; k < clientsCount; k++)
+  {
+    QuantisdClient *client = &clients[(firstClient + k) % clientsCount];
+    size_t pending = QuantisdPendingOutput(client);
+    size_t available = client->inputSize / sizeof(QuantisDaemonRequest);
+
+    client->batchCount = 0u;
+    client->batchPartial = 0u;
+    while (!client->closed &&
+           (client->batchCount < available) &&
+           (pending <= QUANTISD_MAX_PENDING_OUTPUT))
+    {
+      size_t missing = QuantisdMissingSize(client, client->batchCount);
+      if (total + missing > QUANTISD_BATCH_SIZE)
+      {
+        break;
+      }
+
+      total += missing;
+      pending += sizeof(QuantisDaemonResponse) + missing;
+      client->batchCount++;
+    }
+    if (client->batchCount > 0u)
+    {
+      served = 1;
+    }
+  }
+
+  /* Fills the rest of the batch with the beginning of requests not fitting */
+  for (k = 0u; (k < clientsCount) && (total < QUANTISD_BATCH_SIZE); k++)
+  {
+    QuantisdClient *client = &clients[(firstClient + k) % clientsCount];
+    size_t available = client->inputSize / sizeof(QuantisDaemonRequest);
+    size_t missing;
+
+    if (client->closed ||
+        (client->batchCount >= available) ||
+        (QuantisdPendingOutput(client) > QUANTISD_MAX_PENDING_OUTPUT))
+    {
+      continue;
+    }
+
+    missing = QuantisdMissingSize(client, client->batchCount);
+    client->batchPartial = QUANTISD_BATCH_SIZE - total;
+    if (client->batchPartial > missing)
+    {
+      client->batchPartial = missing;
+    }
+    total += client->batchPartial;
+    served = 1;
+  }
+
+  if (!served)
+  {
+    return;
+  }
+
+  if (total > 0u)
+  {
+    result = QuantisReadHandled(deviceHandle, batch, total);
+    if ((result >= 0) && ((size_t)result != total))
+    {
+      result = QUANTIS_ERROR_IO;
+    }
+  }
+
+  /* Same order as above, so that offset matches the shares of the clients */
+  for (k = 0u; k < clientsCount; k++)
+  {
+    QuantisdClient *client = &clients[(firstClient + k) % clientsCount];
+    size_t consumed = client->batchCount;
+    size_t j;
+
+    if ((result < 0) && (client->batchPartial > 0u))
+    {
+      /* Reports the error to the partial request as well */
+      consumed++;
+    }
+
+    for (j = 0u; j < consumed; j++)
+    {
+      QuantisDaemonRequest request = QuantisdGetRequest(client, j);
+      long size = QuantisdRequestSize(&request);
+      size_t alreadySent = (j == 0u) ? client->requestServed : 0u;
+      size_t missing;
+
+      if (size < 0)
+      {
+        QuantisdAppendResponse(client, (int)size, NULL, 0u);
+        continue;
+      }
+
+      if (result < 0)
+      {
+        if (alreadySent > 0u)
+        {
+          /* The response has started with a size: the client cannot be told */
+          client->closed = 1;
+        }
+        QuantisdAppendResponse(client, result, NULL, 0u);
+        continue;
+      }
+
+      missing = (size_t)size - alreadySent;
+      if (alreadySent == 0u)
+      {
+        QuantisdAppendResponse(client, (int)size, batch + offset, missing);
+      }
+      else
+      {
+        QuantisdAppend(client, batch + offset, missing);
+      }
+      offset += missing;
+    }
+
+    if ((result >= 0) && (client->batchPartial > 0u))
+    {
+      QuantisDaemonRequest request = QuantisdGetRequest(client, consumed);
+      size_t alreadySent = (consumed == 0u) ? client->requestServed : 0u;
+
+      if (alreadySent == 0u)
+      {
+        QuantisdAppendResponse(client, (int)request.size, batch + offset, client->batchPartial);
+      }
+      else
+      {
+        QuantisdAppend(client, batch + offset, client->batchPartial);
+      }
+      offset += client->batchPartial;
+      client->requestServed = alreadySent + client->batchPartial;
+    }
+    else if (consumed > 0u)
+    {
+      client->requestServed = 0u;
+    }
+
+    /* Keeps the requests not served, and a partial request, for later */
+    client->inputSize -= consumed * sizeof(QuantisDaemonRequest);
+    memmove(client->input, client->input + consumed * sizeof(QuantisDaemonRequest), client->inputSize);
+    client->batchCount = 0u;
+    client->batchPartial = 0u;
+  }
+}
+
+static int QuantisdListen(const char *socketPath)
+{
+  struct sockaddr_un address;
+  int listenSocket;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address.sun_path))
+  {
+    fprintf(stderr, "Socket path too long: %s\n", socketPath);
+    return -1;
+  }
+  strcpy(address.sun_path, socketPath);
+
+  listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenSocket < 0)
+  {
+    perror("socket");
+    return -1;
+  }
+
+  /* Replaces the socket left by a daemon that did not exit cleanly */
+  if (connect(listenSocket, (struct sockaddr *)&address, sizeof(address)) == 0)
+  {
+    fprintf(stderr, "A daemon is already listening on %s\n", socketPath);
+    close(listenSocket);
+    return -1;
+  }
+  unlink(socketPath);
+
+  if ((bind(listenSocket, (struct sockaddr *)&address, sizeof(address)) < 0) ||
+      (listen(listenSocket, SOMAXCONN) < 0))
+  {
+    perror(socketPath);
+    close(listenSocket);
+    return -1;
+  }
+
+  fcntl(listenSocket, F_SETFL, fcntl(listenSocket, F_GETFL) | O_NONBLOCK);
+
+  return listenSocket;
+}
+
+static void QuantisdUsage(const char *program)
+{
+  fprintf(stderr,
+          "Usage: %s [-t type] [-n number] [-s socket | -m name] [-p prefetch] [-H]\n"
+          "  -t type      Device Type: 1 - PCI-E, 2 - USB, 4 - Simulator (default: 2)\n"
+          "  -n number    Device Number (default: 0)\n"
+          "  -s socket    Path of the Unix socket (default: %s)\n"
+          "  -m name      Publish a shared memory ring of this name instead of a socket\n"
+          "  -p prefetch  Size in bytes of the prefetch buffer, 0 to disable (default: %u)\n"
+          "  -H           Allocate buffers with hugepages\n",
+          program,
+          QUANTIS_DAEMON_DEFAULT_SOCKET,
+          (unsigned int)QUANTISD_DEFAULT_PREFETCH_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+  QuantisDeviceType deviceType = QUANTIS_DEVICE_USB;
+  unsigned int deviceNumber = 0u;
+  const char *socketPath = QUANTIS_DAEMON_DEFAULT_SOCKET;
+  const char *shmName = NULL;
+  QuantisShmProducer *shmProducer = NULL;
+  size_t prefetchSize = QUANTISD_DEFAULT_PREFETCH_SIZE;
+  QuantisDeviceHandle *deviceHandle = NULL;
+  QuantisdClient *clients = NULL;
+  size_t clientsCount = 0u;
+  struct pollfd *pollFds = NULL;
+  unsigned char *batch = NULL;
+  size_t firstClient = 0u;
+  struct sigaction action;
+  sigset_t stopSignals;
+  int listenSocket = -1;
+  int numaNode;
+  int exitCode = EXIT_FAILURE;
+  int option;
+  int result;
+  size_t i;
+
+  while ((option = getopt(argc, argv, "t:n:s:m:p:Hh")) != -1)
+  {
+    switch (option)
+    {
+    case 't':
+      deviceType = (QuantisDeviceType)strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      deviceNumber = (unsigned int)strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      socketPath = optarg;
+      break;
+    case 'm':
+      shmName = optarg;
+      break;
+    case 'p':
+      prefetchSize = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'H':
+      QuantisSetMemoryMode(QUANTIS_MEMORY_HUGEPAGES);
+      break;
+    default:
+      QuantisdUsage(argv[0]);
+      return (option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  /* Blocked in all the threads, so that the main thread can wait for them */
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  if (shmName != NULL)
+  {
+    pthread_sigmask(SIG_BLOCK, &stopSignals, NULL);
+  }
+
+  result = QuantisOpen(deviceType, deviceNumber, &deviceHandle);
+  if (result < 0)
+  {
+    fprintf(stderr, "Cannot open device: %s\n", QuantisStrError((QuantisError)result));
+    return EXIT_FAILURE;
+  }
+
+  /* Copies out of the buffers from the node of the device */
+  numaNode = QuantisGetNumaNode(deviceHandle);
+  if (numaNode >= 0)
+  {
+    QuantisBindThreadToNumaNode(numaNode);
+  }
+
+  if (prefetchSize > 0u)
+  {
+    result = QuantisStartPrefetch(deviceHandle, prefetchSize);
+    if (result < 0)
+    {
+      fprintf(stderr, "Cannot start prefetch: %s\n", QuantisStrError((QuantisError)result));
+      goto cleanup;
+    }
+  }
+
+  /* Interrupts poll() to exit cleanly, and lets send() report closed clients */
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = QuantisdStop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (shmName != NULL)
+  {
+    /* Refuses to take the ring over from a running daemon, as for the socket */
+    if (QuantisShmIsActive(shmName))
+    {
+      fprintf(stderr, "A daemon is already publishing %s\n", shmName);
+      goto cleanup;
+    }
+
+    result = QuantisShmCreate(shmName, deviceHandle, 0u, 0u, &shmProducer);
+    if (result < 0)
+    {
+      fprintf(stderr, "Cannot create shared memory ring: %s\n", QuantisStrError((QuantisError)result));
+      goto cleanup;
+    }
+
+    /* Consumers read the ring without the daemon, which only waits to exit */
+    fprintf(stderr, "Publishing device %u of type %d in %s\n", deviceNumber, (int)deviceType, shmName);
+    sigwait(&stopSignals, &option);
+
+    exitCode = EXIT_SUCCESS;
+    goto cleanup;
+  }
+
+  clients = (QuantisdClient *)calloc(QUANTISD_MAX_CLIENTS, sizeof(QuantisdClient));
+  pollFds = (struct pollfd *)calloc(QUANTISD_MAX_CLIENTS + 1u, sizeof(struct pollfd));
+  batch = (unsigned char *)malloc(QUANTISD_BATCH_SIZE);
+  if ((clients == NULL) || (pollFds == NULL) || (batch == NULL))
+  {
+    fprintf(stderr, "%s\n", QuantisStrError(QUANTIS_ERROR_NO_MEMORY));
+    goto cleanup;
+  }
+
+  listenSocket = QuantisdListen(socketPath);
+  if (listenSocket < 0)
+  {
+    goto cleanup;
+  }
+
+  fprintf(stderr, "Serving device %u of type %d on %s\n", deviceNumber, (int)deviceType, socketPath);
+
+  while (running)
+  {
+    size_t polledCount = clientsCount;
+    int timeout = -1;
+
+    pollFds[0].fd = listenSocket;
+    pollFds[0].events = (clientsCount < QUANTISD_MAX_CLIENTS) ? POLLIN : 0;
+    for (i = 0u; i < polledCount; i++)
+    {
+      QuantisdClient *client = &clients[i];
+
+      pollFds[i + 1u].fd = client->socket;
+      pollFds[i + 1u].events = 0;
+      if ((client->inputSize < sizeof(client->input)) &&
+          (QuantisdPendingOutput(client) <= QUANTISD_MAX_PENDING_OUTPUT))
+      {
+        pollFds[i + 1u].events |= POLLIN;
+      }
+      if (QuantisdPendingOutput(client) > 0u)
+      {
+        pollFds[i + 1u].events |= POLLOUT;
+      }
+
+      /* Requests left by the previous batch are served without waiting */
+      if ((client->inputSize >= sizeof(QuantisDaemonRequest)) &&
+          (QuantisdPendingOutput(client) <= QUANTISD_MAX_PENDING_OUTPUT))
+      {
+        timeout = 0;
+      }
+    }
+
+    if (poll(pollFds, polledCount + 1u, timeout) < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("poll");
+      break;
+    }
+
+    for (i = 0u; i < polledCount; i++)
+    {
+      if (pollFds[i + 1u].revents & (POLLHUP | POLLERR | POLLNVAL))
+      {
+        /* The client can no longer read responses */
+        clients[i].closed = 1;
+        continue;
+      }
+      if (pollFds[i + 1u].revents & POLLIN)
+      {
+        QuantisdReceive(&clients[i]);
+      }
+      if (pollFds[i + 1u].revents & POLLOUT)
+      {
+        QuantisdFlush(&clients[i]);
+      }
+    }
+
+    if (pollFds[0].revents & POLLIN)
+    {
+      while (clientsCount < QUANTISD_MAX_CLIENTS)
+      {
+        int clientSocket = accept(listenSocket, NULL, NULL);
+        if (clientSocket < 0)
+        {
+          break;
+        }
+        fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL) | O_NONBLOCK);
+        memset(&clients[clientsCount], 0, sizeof(QuantisdClient));
+        clients[clientsCount].socket = clientSocket;
+
+        /* The first requests are usually sent right after connecting */
+        QuantisdReceive(&clients[clientsCount]);
+        clientsCount++;
+      }
+    }
+
+    if (clientsCount > 0u)
+    {
+      /* Every batch starts with another client */
+      firstClient = (firstClient + 1u) % clientsCount;
+      QuantisdServe(deviceHandle, clients, clientsCount, firstClient, batch);
+    }
+
+    /* Sends the responses right away, and drops the closed clients */
+    for (i = 0u; i < clientsCount;)
+    {
+      QuantisdFlush(&clients[i]);
+      if (clients[i].closed)
+      {
+        close(clients[i].socket);
+        free(clients[i].output);
+        clients[i] = clients[clientsCount - 1u];
+        clientsCount--;
+      }
+      else
+      {
+        i++;
+      }
+    }
+  }
+
+  exitCode = EXIT_SUCCESS;
+
+cleanup:
+  QuantisShmDestroy(shmProducer);
+  for (i = 0u; i < clientsCount; i++)
+  {
+    close(clients[i].socket);
+    free(clients[i].output);
+  }
+  if (listenSocket >= 0)
+  {
+    close(listenSocket);
+    unlink(socketPath);
+  }
+  free(batch);
+  free(pollFds);
+  free(clients);
+  QuantisClose(deviceHandle);
+
+  return exitCode;
+}
@@ -6,10 +6,30 @@
 //
 
 import Foundation
+import СQuantis
 
-enum QuantisError: Error {
+public enum QuantisError: Error {
     case noResult
     case deviceError
     case invalidParameters
     case tooLargeRequest
+    // The C library failed with a QUANTIS_ERROR code
+    case readError(code: Int32)
+}
+
+extension QuantisError: CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .noResult:
+            return "No result"
+        case .deviceError:
+            return "Device error"
+        case .invalidParameters:
+            return "Invalid parameters"
+        case .tooLargeRequest:
+            return "Request too large"
+        case .readError(let code):
+            return "\(String(cString: QuantisStrError(СQuantis.QuantisError(rawValue: code)))) (\(code))"
+        }
+    }
 }
@@ -7,6 +7,7 @@
 // QuantisDevice:
 // 1 = QUANTIS_PCI_DEVICE
 // 2 = QUANTIS_USB_DEVICE
+// 4 = QUANTIS_DEVICE_SIM (software simulator)
 
 import Foundation
 import СQuantis
@@ -27,23 +28,39 @@ public protocol SwiftQuantis {
     // MARK: Read and scale array of Int in min to max range
     func quantisReadScaledIntArray(count: Int, min: Int32, max: Int32) throws -> [Int32]
     
+    // MARK: Read and scale array of Double in min to max range
+    func quantisReadScaledDoubleArray(count: Int, min: Double, max: Double) throws -> [Double]
+    
     // MARK: Read array of String in required byte length
     func quantisStringArray(count: Int, length: Int) throws -> [String]
     
     // MARK: Read random binary in request byte size
     func quantisRead(bytes: Int) throws -> Data
     
+    // MARK: Fill a caller buffer with random binary, without intermediate copy
+    func quantisRead(into buffer: UnsafeMutableRawBufferPointer) throws
+    
+    // MARK: Stream random binary of any size in chunks, body returns false to stop
+    func quantisReadStream(bytes: UInt64, chunkSize: Int, body: (UnsafeRawBufferPointer) throws -> Bool) throws
+    
     // MARK: Generate random UInt64 as per RandomNumberGenerator type
     func next() -> UInt64
 }
 
 public typealias Quantis = QuantisFunctions
 
+// Largest request of a single QuantisRead call
+let quantisMaxReadSize = 16 * 1024 * 1024
+
 public typealias QuantisDevice = QuantisDeviceType
 
 public final class QuantisFunctions: RandomNumberGenerator, SwiftQuantis {
     public var device: QuantisDevice
     public var deviceNumber: UInt32
+    
+    // Buffered generator serving next(), opened on first use
+    private var generator: QuantisRandomGenerator?
+    private let generatorLock = NSLock()
 
     public init(device: QuantisDevice, deviceNumber: UInt32) {
         self.device = device
@@ -55,12 +72,43 @@ public final class QuantisFunctions: RandomNumberGenerator, SwiftQuantis {
         return count
     }
     
-    public func getDeviceInfo() -> (boardVersion: Int32, serialNumber: String, manufacturer: String) {
-        let boardVersion = QuantisGetBoardVersion(device, deviceNumber)
-        let serialNumber = String(cString: (QuantisGetSerialNumber(device, deviceNumber)))
-        let manufacturer = String(cString: (QuantisGetManufacturer(device, deviceNumber)))
-        
-        return (boardVersion, serialNumber, manufacturer)
+    // MARK: Snapshot of the device information, read with a single device opening
+    public struct DeviceInfo {
+        public let boardVersion: Int32
+        public let serialNumber: String
+        public let manufacturer: String
+        public let modulesCount: Int32
+        public let modulesMask: Int32
+        public let modulesStatus: Int32
+        public let modulesPower: Int32
+        public let modulesDataRate: Int32
+        // PCI bus number in bits 8-15 and device number in bits 0-7 (PCI only)
+        public let busDeviceId: Int32
+        
+        init(_ info: inout QuantisDeviceInfo) {
+            boardVersion = info.boardVersion
+            serialNumber = withUnsafeBytes(of: &info.serialNumber) { String(cString: $0.bindMemory(to: CChar.self).baseAddress!) }
+            manufacturer = withUnsafeBytes(of: &info.manufacturer) { String(cString: $0.bindMemory(to: CChar.self).baseAddress!) }
+            modulesCount = info.modulesCount
+            modulesMask = info.modulesMask
+            modulesStatus = info.modulesStatus
+            modulesPower = info.modulesPower
+            modulesDataRate = info.modulesDataRate
+            busDeviceId = info.busDeviceId
+        }
+    }
+    
+    public func getDeviceInfo() throws -> DeviceInfo {
+        return try QuantisFunctions.deviceInfo(device: device, deviceNumber: deviceNumber)
+    }
+    
+    static func deviceInfo(device: QuantisDevice, deviceNumber: UInt32) throws -> DeviceInfo {
+        var info = QuantisDeviceInfo()
+        let result = QuantisGetDeviceInfo(device, deviceNumber, &info)
+        if result < 0 {
+            throw QuantisError.readError(code: result)
+        }
+        return DeviceInfo(&info)
     }
     
     public func printAllCards() {
@@ -79,14 +127,16 @@ public final class QuantisFunctions: RandomNumberGenerator, SwiftQuantis {
             if deviceCount > 0 {
                 for i in 1 ... deviceCount {
                     let deviceNumber = UInt32(i-1)
-                    let boardVersion = QuantisGetBoardVersion(QuantisDevice(device), UInt32(deviceNumber))
-                    let serialNumber = String(cString: (QuantisGetSerialNumber(QuantisDevice(device), UInt32(deviceNumber))))
-                    let manufacturer = String(cString: (QuantisGetManufacturer(QuantisDevice(device), UInt32(deviceNumber))))
-                    
                     print("     - Details for device #\(deviceNumber)")
-                    print("      core version: \(boardVersion)")
-                    print("      serial number: \(serialNumber)")
-                    print("      manufacturer: \(manufacturer)")
+                    
+                    guard let info = try? QuantisFunctions.deviceInfo(device: QuantisDevice(device), deviceNumber: deviceNumber) else {
+                        print("      not available")
+                        continue
+                    }
+                    print("      core version: \(info.boardVersion)")
+                    print("      serial number: \(info.serialNumber)")
+                    print("      manufacturer: \(info.manufacturer)")
+                    print("      modules: \(info.modulesCount) (mask \(info.modulesMask), status \(info.modulesStatus))")
                 }
             }
         }
@@ -275,40 +325,18 @@ public final class QuantisFunctions: RandomNumberGenerator, SwiftQuantis {
     }
     
     public func quantisReadScaledIntArray(count: Int, min: Int32, max: Int32) throws -> [Int32] {
-        if min > max {
-            throw QuantisError.invalidParameters
-        }
-        
-        // Calculate size of the data to be generated
-        let size = MemoryLayout<Int32>.size * count
-        
-        if size > 16 * 1024 * 1024 {
-            throw QuantisError.tooLargeRequest
-        }
-        
-        // Allocate memory for the requested amount of Int32
-        let pointer = UnsafeMutableRawPointer.allocate(byteCount: size, alignment: MemoryLayout<Int32>.alignment)
-        
-        let deviceHandle = QuantisRead(device, deviceNumber, pointer, size)
+        // Values are scaled by the C library directly into the array
+        let result: [Int32] = try makeArray(count: count) { try quantisReadScaled(into: $0, min: min, max: max) }
         
-        defer {
-            pointer.deallocate()
-        }
-        
-        if deviceHandle < 0 {
-            throw QuantisError.deviceError
+        guard !result.isEmpty else {
+            throw QuantisError.noResult
         }
         
-        let range: Int32 = (max - min) + 1
-        var result: [Int32] = []
-        
-        for i in 0..<count {
-            // Convert value to Int32
-            let value = pointer.load(fromByteOffset: MemoryLayout<Int32>.size * i, as: Int32.self)
-            // Scale in the required range
-            let scaledValue = (value % range + range) % range + min
-            result.append(scaledValue)
-        }
+        return result
+    }
+    
+    public func quantisReadScaledDoubleArray(count: Int, min: Double, max: Double) throws -> [Double] {
+        let result: [Double] = try makeArray(count: count) { try quantisReadScaled(into: $0, min: min, max: max) }
         
         guard !result.isEmpty else {
             throw QuantisError.noResult
@@ -339,38 +367,84 @@ public final class QuantisFunctions: RandomNumberGenerator, SwiftQuantis {
     }
     
     public func quantisRead(bytes: Int) throws -> Data {
-        var buffer = Data(count: bytes)
+        if bytes < 0 {
+            throw QuantisError.invalidParameters
+        }
+        if bytes == 0 {
+            return Data()
+        }
         
-        if buffer.count > 16 * 1024 * 1024 {
+        // Read straight into the storage handed over to Data, without zero-filling it first
+        guard let pointer = malloc(bytes) else {
             throw QuantisError.tooLargeRequest
         }
+        do {
+            try quantisRead(into: UnsafeMutableRawBufferPointer(start: pointer, count: bytes))
+        } catch {
+            free(pointer)
+            throw error
+        }
+        return Data(bytesNoCopy: pointer, count: bytes, deallocator: .free)
+    }
+    
+    public func quantisReadStream(bytes: UInt64, chunkSize: Int = 0, body: (UnsafeRawBufferPointer) throws -> Bool) throws {
+        // 0 bytes would be an unlimited stream in the C library
+        if bytes == 0 {
+            return
+        }
         
-        let _ = buffer.withUnsafeMutableBytes {
-            QuantisRead(device, deviceNumber, $0.baseAddress!, bytes)
+        try withoutActuallyEscaping(body) { body in
+            let context = QuantisStreamContext(body: body)
+            
+            // The C callback runs on this thread, between chunks read in the background
+            let result = withExtendedLifetime(context) {
+                QuantisReadStream(device, deviceNumber, bytes, chunkSize, { buffer, size, userData in
+                    let context = Unmanaged<QuantisStreamContext>.fromOpaque(userData!).takeUnretainedValue()
+                    do {
+                        return try context.body(UnsafeRawBufferPointer(start: buffer, count: size)) ? 0 : 1
+                    } catch {
+                        context.error = error
+                        return 1
+                    }
+                }, Unmanaged.passUnretained(context).toOpaque())
+            }
+            
+            if let error = context.error {
+                throw error
+            }
+            
+            if result < 0 {
+                throw QuantisError.deviceError
+            }
         }
-        return buffer
     }
     
     public func next() -> UInt64 {
-        // Calculate size of the data to be generated
-        let size = MemoryLayout<UInt64>.size
-        
-        // Allocate memory for the requested amount of Int32
-        let pointer = UnsafeMutableRawPointer.allocate(byteCount: size, alignment: MemoryLayout<UInt64>.alignment)
-        
-        // Deallocate when function returns
+        generatorLock.lock()
         defer {
-            pointer.deallocate()
+            generatorLock.unlock()
         }
         
-        let deviceHandle = QuantisRead(device, deviceNumber, pointer, size)
-        
-        if deviceHandle < 0 {
-            return 0
+        // Reopened when device or deviceNumber changed
+        if generator == nil || generator!.device != device || generator!.deviceNumber != deviceNumber {
+            generator = nil
+            do {
+                generator = try QuantisRandomGenerator(device: device, deviceNumber: deviceNumber)
+            } catch {
+                fatalError("Quantis device \(deviceNumber) of type \(device.rawValue): \(error)")
+            }
         }
         
-        let randomUInt64 = pointer.load(as: UInt64.self)
-        
-        return randomUInt64
+        return generator!.next()
+    }
+}
+
+// Carries the Swift closure of quantisReadStream through the C callback
+private final class QuantisStreamContext {
+    let body: (UnsafeRawBufferPointer) throws -> Bool
+    var error: Error?
+    
+    init(body: @escaping (UnsafeRawBufferPointer) throws -> Bool) {
+        self.body = body
     }
 }
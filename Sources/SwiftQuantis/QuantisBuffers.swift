@@ -0,0 +1,135 @@
+//
+//  QuantisBuffers.swift
+//  
+//
+
+import Foundation
+import СQuantis
+
+// MARK: Bulk reads straight into caller memory
+//
+// Values are read and scaled by the batch functions of the C library
+// directly into the destination, which may be larger than 16 MiB: no
+// temporary buffer, no zero-filling, a single pass. The array variants build
+// their result with Array(unsafeUninitializedCapacity:), so that generating
+// N values costs one allocation.
+extension QuantisFunctions {
+    // MARK: Fill a raw buffer with random bytes
+    public func quantisRead(into buffer: UnsafeMutableRawBufferPointer) throws {
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        
+        var offset = 0
+        while offset < buffer.count {
+            let size = Swift.min(buffer.count - offset, quantisMaxReadSize)
+            let result = QuantisRead(device, deviceNumber, baseAddress + offset, size)
+            if result < 0 {
+                throw QuantisError.readError(code: result)
+            }
+            if Int(result) != size {
+                throw QuantisError.noResult
+            }
+            offset += size
+        }
+    }
+    
+    // MARK: Fill a buffer with Int32 scaled in min to max range
+    public func quantisReadScaled(into buffer: UnsafeMutableBufferPointer<Int32>, min: Int32, max: Int32) throws {
+        if min > max {
+            throw QuantisError.invalidParameters
+        }
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        try check(QuantisReadScaledIntArray(device, deviceNumber, baseAddress, buffer.count, min, max))
+    }
+    
+    // MARK: Fill a buffer with Int16 scaled in min to max range
+    public func quantisReadScaled(into buffer: UnsafeMutableBufferPointer<Int16>, min: Int16, max: Int16) throws {
+        if min > max {
+            throw QuantisError.invalidParameters
+        }
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        try check(QuantisReadScaledShortArray(device, deviceNumber, baseAddress, buffer.count, min, max))
+    }
+    
+    // MARK: Fill a buffer with Double scaled in min to max range
+    public func quantisReadScaled(into buffer: UnsafeMutableBufferPointer<Double>, min: Double, max: Double) throws {
+        if min > max {
+            throw QuantisError.invalidParameters
+        }
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        try check(QuantisReadScaledDoubleArray(device, deviceNumber, baseAddress, buffer.count, min, max))
+    }
+    
+    // MARK: Fill a buffer with Float scaled in min to max range
+    public func quantisReadScaled(into buffer: UnsafeMutableBufferPointer<Float>, min: Float, max: Float) throws {
+        if min > max {
+            throw QuantisError.invalidParameters
+        }
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        try check(QuantisReadScaledFloatArray(device, deviceNumber, baseAddress, buffer.count, min, max))
+    }
+    
+    // MARK: Fill a buffer with Double in [0, 1)
+    public func quantisReadUniform(into buffer: UnsafeMutableBufferPointer<Double>) throws {
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        try check(QuantisReadDoubleArray_01(device, deviceNumber, baseAddress, buffer.count))
+    }
+    
+    // MARK: Fill a buffer with Float in [0, 1)
+    public func quantisReadUniform(into buffer: UnsafeMutableBufferPointer<Float>) throws {
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+        try check(QuantisReadFloatArray_01(device, deviceNumber, baseAddress, buffer.count))
+    }
+    
+    // MARK: Read and scale array of Int16 in min to max range
+    public func quantisReadScaledShortArray(count: Int, min: Int16, max: Int16) throws -> [Int16] {
+        return try makeArray(count: count) { try quantisReadScaled(into: $0, min: min, max: max) }
+    }
+    
+    // MARK: Read and scale array of Float in min to max range
+    public func quantisReadScaledFloatArray(count: Int, min: Float, max: Float) throws -> [Float] {
+        return try makeArray(count: count) { try quantisReadScaled(into: $0, min: min, max: max) }
+    }
+    
+    // MARK: Read array of Double in [0, 1)
+    public func quantisReadUniformDoubleArray(count: Int) throws -> [Double] {
+        return try makeArray(count: count) { try quantisReadUniform(into: $0) }
+    }
+    
+    // MARK: Read array of Float in [0, 1)
+    public func quantisReadUniformFloatArray(count: Int) throws -> [Float] {
+        return try makeArray(count: count) { try quantisReadUniform(into: $0) }
+    }
+    
+    // Builds an array of count values written in place by fill
+    func makeArray<T>(count: Int, _ fill: (UnsafeMutableBufferPointer<T>) throws -> Void) throws -> [T] {
+        if count < 0 {
+            throw QuantisError.invalidParameters
+        }
+        
+        return try [T](unsafeUninitializedCapacity: count) { buffer, initializedCount in
+            // The buffer may be larger than requested
+            try fill(UnsafeMutableBufferPointer(rebasing: buffer[0..<count]))
+            initializedCount = count
+        }
+    }
+    
+    private func check(_ result: Int32) throws {
+        if result < 0 {
+            throw QuantisError.readError(code: result)
+        }
+    }
+}
@@ -0,0 +1,212 @@
+//
+//  QuantisChunkSequence.swift
+//  
+//
+
+import Foundation
+import СQuantis
+
+// MARK: Asynchronous sequence of random chunks
+//
+// Chunks of chunkSize random bytes are read by a dedicated thread, which
+// keeps up to depth chunks ahead of the consumer and then waits for it
+// (back-pressure), so that awaiting tasks never block their thread on the
+// device. Device errors are thrown by the iteration, which then ends.
+// Cancelling the consuming task, or dropping the iterator, stops the thread
+// once its current read is done.
+//
+//     for try await chunk in quantis.quantisChunks(chunkSize: 4096) {
+//         ...
+//     }
+@available(macOS 10.15, *)
+public struct QuantisChunkSequence: AsyncSequence {
+    public typealias Element = Data
+    
+    public let device: QuantisDevice
+    public let deviceNumber: UInt32
+    public let chunkSize: Int
+    public let depth: Int
+    // Total number of bytes, nil for an endless sequence
+    public let bytes: UInt64?
+    
+    public func makeAsyncIterator() -> AsyncIterator {
+        let reader = QuantisChunkReader(depth: depth)
+        reader.start(quantis: Quantis(device: device, deviceNumber: deviceNumber), chunkSize: chunkSize, bytes: bytes)
+        return AsyncIterator(owner: QuantisChunkReaderOwner(reader: reader))
+    }
+    
+    public struct AsyncIterator: AsyncIteratorProtocol {
+        fileprivate let owner: QuantisChunkReaderOwner
+        
+        public mutating func next() async throws -> Data? {
+            return try await owner.reader.next()
+        }
+    }
+}
+
+@available(macOS 10.15, *)
+extension QuantisFunctions {
+    // MARK: Stream random chunks asynchronously, reading ahead up to depth chunks
+    public func quantisChunks(chunkSize: Int, depth: Int = 4, bytes: UInt64? = nil) -> QuantisChunkSequence {
+        precondition(chunkSize > 0 && depth > 0, "chunkSize and depth must be positive")
+        return QuantisChunkSequence(device: device, deviceNumber: deviceNumber,
+                                    chunkSize: chunkSize, depth: depth, bytes: bytes)
+    }
+}
+
+// Stops the reader when the iterator goes away (the thread only holds the reader)
+@available(macOS 10.15, *)
+private final class QuantisChunkReaderOwner {
+    let reader: QuantisChunkReader
+    
+    init(reader: QuantisChunkReader) {
+        self.reader = reader
+    }
+    
+    deinit {
+        reader.cancel()
+    }
+}
+
+// Bounded queue between the reader thread and the consuming task
+@available(macOS 10.15, *)
+private final class QuantisChunkReader {
+    private let condition = NSCondition()
+    private let depth: Int
+    private var chunks: [Data] = []
+    private var waiting: CheckedContinuation<Data?, Error>?
+    private var error: Error?
+    private var finished = false
+    private var cancelled = false
+    
+    init(depth: Int) {
+        self.depth = depth
+    }
+    
+    func start(quantis: Quantis, chunkSize: Int, bytes: UInt64?) {
+        var remaining = bytes
+        
+        let thread = Thread { [self] in
+            while true {
+                condition.lock()
+                while chunks.count >= depth && !cancelled {
+                    condition.wait()
+                }
+                let stop = cancelled
+                condition.unlock()
+                if stop {
+                    return
+                }
+                
+                // Reads the next chunk, nil once all the bytes are read
+                let result = Result<Data?, Error> {
+                    var size = chunkSize
+                    if let left = remaining {
+                        if left == 0 {
+                            return nil
+                        }
+                        size = Int(Swift.min(UInt64(chunkSize), left))
+                        remaining = left - UInt64(size)
+                    }
+                    return try quantis.quantisRead(bytes: size)
+                }
+                
+                if !publish(result) {
+                    return
+                }
+            }
+        }
+        thread.name = "Quantis chunk reader"
+        thread.start()
+    }
+    
+    // Hands a result to the consumer, returns false when the thread must end
+    private func publish(_ result: Result<Data?, Error>) -> Bool {
+        condition.lock()
+        if cancelled {
+            condition.unlock()
+            return false
+        }
+        
+        let continuation = waiting
+        waiting = nil
+        var more = true
+        
+        switch result {
+        case .success(let chunk?):
+            if continuation == nil {
+                chunks.append(chunk)
+            }
+        case .success(nil):
+            finished = true
+            more = false
+        case .failure(let failure):
+            // Thrown once the chunks read before are consumed
+            if continuation == nil {
+                error = failure
+            }
+            finished = true
+            more = false
+        }
+        condition.unlock()
+        
+        continuation?.resume(with: result)
+        return more
+    }
+    
+    func next() async throws -> Data? {
+        try Task.checkCancellation()
+        
+#if compiler(>=5.7)
+        return try await withTaskCancellationHandler(operation: {
+            try await self.waitForChunk()
+        }, onCancel: {
+            self.cancel()
+        })
+#else
+        // withTaskCancellationHandler(operation:onCancel:) needs Swift 5.7
+        return try await withTaskCancellationHandler(handler: {
+            self.cancel()
+        }, operation: {
+            try await self.waitForChunk()
+        })
+#endif
+    }
+    
+    private func waitForChunk() async throws -> Data? {
+        return try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Data?, Error>) in
+            condition.lock()
+            
+            if !chunks.isEmpty {
+                let chunk = chunks.removeFirst()
+                condition.signal()
+                condition.unlock()
+                continuation.resume(returning: chunk)
+            } else if cancelled {
+                condition.unlock()
+                continuation.resume(throwing: CancellationError())
+            } else if let failure = error {
+                error = nil
+                condition.unlock()
+                continuation.resume(throwing: failure)
+            } else if finished {
+                condition.unlock()
+                continuation.resume(returning: nil)
+            } else {
+                waiting = continuation
+                condition.unlock()
+            }
+        }
+    }
+    
+    func cancel() {
+        condition.lock()
+        cancelled = true
+        let continuation = waiting
+        waiting = nil
+        condition.broadcast()
+        condition.unlock()
+        
+        continuation?.resume(throwing: CancellationError())
+    }
+}
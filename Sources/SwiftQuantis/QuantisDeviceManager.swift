@@ -0,0 +1,189 @@
+//
+//  QuantisDeviceManager.swift
+//  
+//
+
+import Foundation
+import Dispatch
+import СQuantis
+
+// MARK: Device manager for Swift structured concurrency
+//
+// Opens every detected device once and keeps its handle for the lifetime of
+// the manager. Requests from any number of tasks are scheduled on the least
+// loaded device, and large requests are split across all the devices with a
+// task group, so that throughput scales with the number of devices.
+//
+// Device reads block, so they never run on the actor nor on the cooperative
+// thread pool: each device has a serial queue of its own, which also keeps a
+// handle from being used by two threads at once.
+//
+// The devices belong to the manager while it exists: other APIs of the
+// library must not open them meanwhile (a USB device can only be claimed
+// once).
+@available(macOS 10.15, *)
+public actor QuantisDeviceManager {
+    public struct DeviceID: Hashable {
+        public let type: UInt32
+        public let number: UInt32
+    }
+    
+    // Requests of at least splitSize bytes are shared between all the devices
+    public let splitSize: Int
+    
+    private let devices: [QuantisManagedDevice]
+    
+    // Bytes requested but not read yet on each device
+    private var pendingBytes: [Int]
+    
+    // types: device types to detect (1 - PCI-E, 2 - USB, 4 - Simulator)
+    public init(types: [QuantisDevice] = [QuantisDevice(1), QuantisDevice(2)], splitSize: Int = 1024 * 1024) throws {
+        var devices: [QuantisManagedDevice] = []
+        for type in types {
+            let count = QuantisCount(type)
+            if count <= 0 {
+                continue
+            }
+            for number in 0..<UInt32(count) {
+                // Devices that cannot be opened (e.g. used by another process) are skipped
+                if let device = QuantisManagedDevice(type: type, number: number) {
+                    devices.append(device)
+                }
+            }
+        }
+        
+        if devices.isEmpty {
+            throw QuantisError.deviceError
+        }
+        if splitSize <= 0 {
+            throw QuantisError.invalidParameters
+        }
+        
+        self.devices = devices
+        self.pendingBytes = [Int](repeating: 0, count: devices.count)
+        self.splitSize = splitSize
+    }
+    
+    public var deviceIDs: [DeviceID] {
+        return devices.map { DeviceID(type: $0.type.rawValue, number: $0.number) }
+    }
+    
+    // MARK: Read random binary in request byte size
+    public func read(bytes: Int) async throws -> Data {
+        if bytes < 0 {
+            throw QuantisError.invalidParameters
+        }
+        if bytes == 0 {
+            return Data()
+        }
+        
+        guard let pointer = malloc(bytes) else {
+            throw QuantisError.tooLargeRequest
+        }
+        do {
+            try await read(into: UnsafeMutableRawBufferPointer(start: pointer, count: bytes))
+        } catch {
+            free(pointer)
+            throw error
+        }
+        return Data(bytesNoCopy: pointer, count: bytes, deallocator: .free)
+    }
+    
+    // MARK: Fill a caller buffer with random binary
+    // The buffer must stay valid until the function returns.
+    public func read(into buffer: UnsafeMutableRawBufferPointer) async throws {
+        guard let baseAddress = buffer.baseAddress, buffer.count > 0 else {
+            return
+        }
+        
+        if buffer.count < splitSize || devices.count == 1 {
+            try await read(on: leastLoadedDevice(), into: baseAddress, size: buffer.count)
+            return
+        }
+        
+        // One part per device, on cache line boundaries
+        let partSize = ((buffer.count / devices.count) + 63) & ~63
+        try await withThrowingTaskGroup(of: Void.self) { group in
+            var offset = 0
+            for index in devices.indices where offset < buffer.count {
+                let size = Swift.min(partSize, buffer.count - offset)
+                let start = baseAddress + offset
+                group.addTask {
+                    try await self.read(on: index, into: start, size: size)
+                }
+                offset += size
+            }
+            try await group.waitForAll()
+        }
+    }
+    
+    private func leastLoadedDevice() -> Int {
+        var best = 0
+        for index in pendingBytes.indices where pendingBytes[index] < pendingBytes[best] {
+            best = index
+        }
+        return best
+    }
+    
+    private func read(on index: Int, into pointer: UnsafeMutableRawPointer, size: Int) async throws {
+        pendingBytes[index] += size
+        defer {
+            pendingBytes[index] -= size
+        }
+        
+        let device = devices[index]
+        let result: Int32 = await withCheckedContinuation { continuation in
+            device.queue.async {
+                continuation.resume(returning: device.read(into: pointer, size: size))
+            }
+        }
+        
+        if result < 0 {
+            throw QuantisError.readError(code: result)
+        }
+    }
+}
+
+// A device opened by the manager, closed when the last reference goes away
+private final class QuantisManagedDevice {
+    let type: QuantisDevice
+    let number: UInt32
+    let queue: DispatchQueue
+    private let handle: UnsafeMutablePointer<QuantisDeviceHandle>
+    
+    init?(type: QuantisDevice, number: UInt32) {
+        var handle: UnsafeMutablePointer<QuantisDeviceHandle>?
+        if QuantisOpen(type, number, &handle) < 0 {
+            return nil
+        }
+        guard let openedHandle = handle else {
+            return nil
+        }
+        
+        self.type = type
+        self.number = number
+        self.handle = openedHandle
+        self.queue = DispatchQueue(label: "Quantis device \(type.rawValue)/\(number)")
+    }
+    
+    deinit {
+        QuantisClose(handle)
+    }
+    
+    // Reads size bytes, by requests of at most 16 MiB. Runs on queue only.
+    func read(into pointer: UnsafeMutableRawPointer, size: Int) -> Int32 {
+        var offset = 0
+        while offset < size {
+            let count = Swift.min(size - offset, quantisMaxReadSize)
+            let result = QuantisReadHandled(handle, pointer + offset, count)
+            if result < 0 {
+                return result
+            }
+            if Int(result) != count {
+                return QUANTIS_ERROR_IO.rawValue
+            }
+            offset += count
+        }
+        return 0
+    }
+}
@@ -0,0 +1,117 @@
+//
+//  QuantisRandomGenerator.swift
+//  
+//
+
+import Foundation
+import СQuantis
+
+// MARK: Buffered RandomNumberGenerator on a Quantis device
+//
+// Serves next() from a block of refillSize bytes, allocated once and refilled
+// with a single QuantisRead when empty. The device stays open in the handle
+// cache of the C library between refills. With prefetch, a background thread
+// of the C library keeps reading the device, so that refills are copies from
+// memory. Int.random(in:using:), shuffle(using:)... then cost a few
+// nanoseconds per value instead of a device request.
+//
+// A generator is not thread safe: use one per thread.
+public final class QuantisRandomGenerator: RandomNumberGenerator {
+    public static let defaultRefillSize = 64 * 1024
+    
+    public let device: QuantisDevice
+    public let deviceNumber: UInt32
+    public let refillSize: Int
+    
+    private let buffer: UnsafeMutableRawPointer
+    private var position: Int
+    
+    // refillSize: bytes read from the device at once, from 8 bytes to 16 MiB
+    // prefetch: read the device in the background, with a buffer of
+    // 2 * refillSize (see QuantisSetPrefetch: the setting applies to all the
+    // reads of the device through its device number, and is kept)
+    public init(device: QuantisDevice, deviceNumber: UInt32,
+                refillSize: Int = QuantisRandomGenerator.defaultRefillSize, prefetch: Bool = false) throws {
+        if refillSize < MemoryLayout<UInt64>.size || refillSize > quantisMaxReadSize {
+            throw QuantisError.invalidParameters
+        }
+        
+        if prefetch {
+            let result = QuantisSetPrefetch(device, deviceNumber, Swift.min(2 * refillSize, quantisMaxReadSize))
+            if result < 0 {
+                throw QuantisError.readError(code: result)
+            }
+        }
+        
+        self.device = device
+        self.deviceNumber = deviceNumber
+        self.refillSize = refillSize
+        self.buffer = UnsafeMutableRawPointer.allocate(byteCount: refillSize, alignment: MemoryLayout<UInt64>.alignment)
+        // Empty until the first refill
+        self.position = refillSize
+    }
+    
+    deinit {
+        buffer.deallocate()
+    }
+    
+    // Bytes left in the block
+    public var available: Int {
+        return refillSize - position
+    }
+    
+    // Reads a new block from the device, discarding the bytes left
+    public func refill() throws {
+        let result = QuantisRead(device, deviceNumber, buffer, refillSize)
+        if result < 0 {
+            throw QuantisError.readError(code: result)
+        }
+        if Int(result) != refillSize {
+            throw QuantisError.noResult
+        }
+        position = 0
+    }
+    
+    // Same as next(), reporting device errors instead of stopping the program
+    public func nextValue() throws -> UInt64 {
+        if refillSize - position < MemoryLayout<UInt64>.size {
+            try refill()
+        }
+        
+        var value: UInt64 = 0
+        withUnsafeMutableBytes(of: &value) {
+            $0.copyMemory(from: UnsafeRawBufferPointer(start: buffer + position, count: MemoryLayout<UInt64>.size))
+        }
+        position += MemoryLayout<UInt64>.size
+        return value
+    }
+    
+    // RandomNumberGenerator cannot report errors: returning non-random values
+    // would be worse than stopping, so a failing device is a fatal error here.
+    // Use nextValue() or fill(_:) to handle device errors.
+    public func next() -> UInt64 {
+        do {
+            return try nextValue()
+        } catch {
+            fatalError("Quantis device \(deviceNumber) of type \(device.rawValue): \(error)")
+        }
+    }
+    
+    // Fills destination with random bytes, from the block first
+    public func fill(_ destination: UnsafeMutableRawBufferPointer) throws {
+        guard let baseAddress = destination.baseAddress else {
+            return
+        }
+        
+        var offset = 0
+        while offset < destination.count {
+            if position == refillSize {
+                try refill()
+            }
+            let count = Swift.min(destination.count - offset, refillSize - position)
+            (baseAddress + offset).copyMemory(from: buffer + position, byteCount: count)
+            position += count
+            offset += count
+        }
+    }
+}
@@ -0,0 +1,129 @@
+//
+//  Benchmark.swift
+//  
+//
+
+import Foundation
+import Dispatch
+
+// MARK: Latency percentiles of a benchmark, in nanoseconds
+struct LatencyStatistics: Codable {
+    let min: UInt64
+    let p50: UInt64
+    let p99: UInt64
+    let p999: UInt64
+    let max: UInt64
+    let mean: Double
+
+    init(samples: [UInt64]) {
+        let sorted = samples.sorted()
+
+        func percentile(_ p: Double) -> UInt64 {
+            guard !sorted.isEmpty else {
+                return 0
+            }
+            let rank = Int((p * Double(sorted.count)).rounded(.up)) - 1
+            return sorted[Swift.min(Swift.max(rank, 0), sorted.count - 1)]
+        }
+
+        self.min = sorted.first ?? 0
+        self.p50 = percentile(0.50)
+        self.p99 = percentile(0.99)
+        self.p999 = percentile(0.999)
+        self.max = sorted.last ?? 0
+        self.mean = sorted.isEmpty ? 0 : Double(sorted.reduce(0, +)) / Double(sorted.count)
+    }
+}
+
+// MARK: Result of a single benchmark
+struct BenchmarkResult: Codable {
+    let name: String
+    let bytesPerOperation: Int
+    let threads: Int
+    let operations: Int
+    let errors: Int
+    let seconds: Double
+    let bytesPerSecond: Double
+    let operationsPerSecond: Double
+    let latencyNs: LatencyStatistics
+}
+
+// MARK: Results of a benchmark run
+struct BenchmarkReport: Codable {
+    let deviceType: UInt32
+    let deviceNumber: UInt32
+    let date: String
+    let results: [BenchmarkResult]
+}
+
+final class Benchmark {
+    private(set) var results: [BenchmarkResult] = []
+
+    private static func now() -> UInt64 {
+        return DispatchTime.now().uptimeNanoseconds
+    }
+
+    // MARK: Run operation `iterations` times on each of `threads` threads.
+    // operation returns false on failure, the latency of every call is recorded.
+    func measure(name: String,
+                 bytesPerOperation: Int,
+                 iterations: Int,
+                 threads: Int = 1,
+                 operation: @escaping () -> Bool) {
+        let count = iterations * threads
+        let samples = UnsafeMutableBufferPointer<UInt64>.allocate(capacity: count)
+        let failures = UnsafeMutableBufferPointer<Int>.allocate(capacity: threads)
+        samples.initialize(repeating: 0)
+        failures.initialize(repeating: 0)
+        defer {
+            samples.deallocate()
+            failures.deallocate()
+        }
+
+        // Each thread only writes its own slice of samples and failures
+        let worker: (Int) -> Void = { thread in
+            for i in 0..<iterations {
+                let start = Benchmark.now()
+                let succeeded = operation()
+                samples[thread * iterations + i] = Benchmark.now() - start
+                if !succeeded {
+                    failures[thread] += 1
+                }
+            }
+        }
+
+        let start = Benchmark.now()
+        if threads == 1 {
+            worker(0)
+        } else {
+            // Reads block on the device, so the queue grows a thread per worker
+            let queue = DispatchQueue(label: "SwiftQuantisBenchmark.workers", attributes: .concurrent)
+            let group = DispatchGroup()
+            for thread in 0..<threads {
+                queue.async(group: group) {
+                    worker(thread)
+                }
+            }
+            group.wait()
+        }
+        let seconds = Double(Benchmark.now() - start) / 1_000_000_000
+
+        let result = BenchmarkResult(
+            name: name,
+            bytesPerOperation: bytesPerOperation,
+            threads: threads,
+            operations: count,
+            errors: failures.reduce(0, +),
+            seconds: seconds,
+            bytesPerSecond: seconds > 0 ? Double(count * bytesPerOperation) / seconds : 0,
+            operationsPerSecond: seconds > 0 ? Double(count) / seconds : 0,
+            latencyNs: LatencyStatistics(samples: Array(samples)))
+        results.append(result)
+
+        let summary = "\(name) [\(bytesPerOperation) B x \(threads) thread(s)]: "
+            + "\(Int(result.bytesPerSecond)) B/s, "
+            + "p50 \(result.latencyNs.p50) ns, p99 \(result.latencyNs.p99) ns, p999 \(result.latencyNs.p999) ns, "
+            + "\(result.errors) error(s)\n"
+        FileHandle.standardError.write(summary.data(using: .utf8)!)
+    }
+}
@@ -0,0 +1,210 @@
+//
+//  Main.swift
+//  
+//
+
+import Foundation
+import ArgumentParser
+import SwiftQuantis
+import СQuantis
+
+@main
+struct QuantisBenchmark: ParsableCommand {
+    static var configuration = CommandConfiguration(
+        abstract: "Measure throughput and latency of the Quantis read path.",
+        discussion: """
+            Results are written as JSON to --output (or standard output),
+            a summary is printed on standard error.
+            """)
+
+    @Option(name: .short, help: "Device Type: 1 - PCI-E, 2  - USB, 4 - Simulator")
+    var type: UInt32 = 4
+
+    @Option(name: .short, help: "Device Number")
+    var number: UInt32 = 0
+
+    @Option(name: .short, help: "Number of operations per benchmark and per thread")
+    var iterations: Int = 1000
+
+    @Option(name: .long, help: "Maximal number of bytes read per benchmark and per thread")
+    var budget: Int = 64 * 1024 * 1024
+
+    @Option(name: .long, help: "Comma separated thread counts of the multi-threaded benchmarks")
+    var threads: String = "1,2,4,8"
+
+    @Option(name: .long, help: "Largest size of the QuantisRead benchmarks, up to 16 MiB")
+    var maxSize: Int = 16 * 1024 * 1024
+
+    @Option(name: .long, help: "Simulator only: data rate of a module in bytes per second, 0 for no limit")
+    var simRate: UInt32?
+
+    @Option(name: .long, help: "Simulator only: latency of a transfer in microseconds")
+    var simLatency: UInt32?
+
+    @Option(name: .long, help: "Write the JSON results to this file")
+    var output: String?
+
+    func validate() throws {
+        guard iterations > 0, budget > 0 else {
+            throw ValidationError("--iterations and --budget must be positive.")
+        }
+        guard maxSize > 0, maxSize <= 16 * 1024 * 1024 else {
+            throw ValidationError("--max-size must be between 1 and 16777216.")
+        }
+        guard !threadCounts.isEmpty else {
+            throw ValidationError("--threads must list positive thread counts.")
+        }
+    }
+
+    var threadCounts: [Int] {
+        return threads.split(separator: ",").compactMap { Int($0.trimmingCharacters(in: .whitespaces)) }.filter { $0 > 0 }
+    }
+
+    // MARK: Number of iterations of a benchmark reading size bytes per operation
+    func iterationCount(for size: Int) -> Int {
+        return Swift.max(1, Swift.min(iterations, budget / size))
+    }
+
+    mutating func run() throws {
+        let device = QuantisDevice(type)
+        let deviceNumber = number
+
+        if device == QUANTIS_DEVICE_SIM {
+            var config = QuantisSimConfig()
+            QuantisSimGetConfig(&config)
+            if let simRate = simRate {
+                config.moduleDataRate = simRate
+            }
+            if let simLatency = simLatency {
+                config.transferLatency = simLatency
+            }
+            if QuantisSimSetConfig(&config) != 0 {
+                throw ValidationError("Invalid simulator configuration.")
+            }
+        }
+
+        guard QuantisCount(device) > Int32(deviceNumber) else {
+            throw ValidationError("Device \(deviceNumber) of type \(type) not found.")
+        }
+
+        let benchmark = Benchmark()
+        let maxSize = self.maxSize
+        let buffer = UnsafeMutableRawPointer.allocate(byteCount: maxSize, alignment: 16)
+        defer {
+            buffer.deallocate()
+        }
+
+        // MARK: QuantisRead from 1 byte to maxSize
+        var size = 1
+        while size <= maxSize {
+            let readSize = size
+            benchmark.measure(name: "QuantisRead", bytesPerOperation: readSize, iterations: iterationCount(for: readSize)) {
+                QuantisRead(device, deviceNumber, buffer, readSize) == Int32(readSize)
+            }
+            size = (size < maxSize && size * 4 > maxSize) ? maxSize : size * 4
+        }
+
+        // MARK: Typed readers
+        let typedIterations = iterationCount(for: 8)
+        benchmark.measure(name: "QuantisReadInt", bytesPerOperation: 4, iterations: typedIterations) {
+            var value: Int32 = 0
+            return QuantisReadInt(device, deviceNumber, &value) == 0
+        }
+        benchmark.measure(name: "QuantisReadShort", bytesPerOperation: 2, iterations: typedIterations) {
+            var value: Int16 = 0
+            return QuantisReadShort(device, deviceNumber, &value) == 0
+        }
+        benchmark.measure(name: "QuantisReadDouble_01", bytesPerOperation: 8, iterations: typedIterations) {
+            var value: Double = 0
+            return QuantisReadDouble_01(device, deviceNumber, &value) == 0
+        }
+        benchmark.measure(name: "QuantisReadFloat_01", bytesPerOperation: 4, iterations: typedIterations) {
+            var value: Float = 0
+            return QuantisReadFloat_01(device, deviceNumber, &value) == 0
+        }
+        benchmark.measure(name: "QuantisReadScaledInt", bytesPerOperation: 4, iterations: typedIterations) {
+            var value: Int32 = 0
+            return QuantisReadScaledInt(device, deviceNumber, &value, 1, 100) == 0
+        }
+        benchmark.measure(name: "QuantisReadScaledShort", bytesPerOperation: 2, iterations: typedIterations) {
+            var value: Int16 = 0
+            return QuantisReadScaledShort(device, deviceNumber, &value, 1, 100) == 0
+        }
+        benchmark.measure(name: "QuantisReadScaledDouble", bytesPerOperation: 8, iterations: typedIterations) {
+            var value: Double = 0
+            return QuantisReadScaledDouble(device, deviceNumber, &value, 1.0, 100.0) == 0
+        }
+        benchmark.measure(name: "QuantisReadScaledFloat", bytesPerOperation: 4, iterations: typedIterations) {
+            var value: Float = 0
+            return QuantisReadScaledFloat(device, deviceNumber, &value, 1.0, 100.0) == 0
+        }
+
+        // MARK: Swift QuantisFunctions
+        let quantis = Quantis(device: device, deviceNumber: deviceNumber)
+        benchmark.measure(name: "Quantis.quantisReadScaledInt", bytesPerOperation: 4, iterations: typedIterations) {
+            (try? quantis.quantisReadScaledInt(min: 1, max: 100)) != nil
+        }
+        benchmark.measure(name: "Quantis.quantisReadScaledDouble", bytesPerOperation: 8, iterations: typedIterations) {
+            (try? quantis.quantisReadScaledDouble(min: 1.0, max: 100.0)) != nil
+        }
+        benchmark.measure(name: "Quantis.quantisReadScaledIntArray", bytesPerOperation: 4 * 1024, iterations: iterationCount(for: 4 * 1024)) {
+            (try? quantis.quantisReadScaledIntArray(count: 1024, min: 1, max: 100)) != nil
+        }
+        benchmark.measure(name: "Quantis.quantisRead", bytesPerOperation: 4096, iterations: iterationCount(for: 4096)) {
+            (try? quantis.quantisRead(bytes: 4096)) != nil
+        }
+        let scaledBuffer = UnsafeMutableBufferPointer<Int32>.allocate(capacity: 1024)
+        defer {
+            scaledBuffer.deallocate()
+        }
+        benchmark.measure(name: "Quantis.quantisReadScaled(into:)", bytesPerOperation: 4 * 1024, iterations: iterationCount(for: 4 * 1024)) {
+            (try? quantis.quantisReadScaled(into: scaledBuffer, min: 1, max: 100)) != nil
+        }
+        benchmark.measure(name: "Quantis.next", bytesPerOperation: 8, iterations: typedIterations) {
+            _ = quantis.next()
+            return true
+        }
+
+        // MARK: Buffered RandomNumberGenerator
+        var generator = try QuantisRandomGenerator(device: device, deviceNumber: deviceNumber)
+        benchmark.measure(name: "QuantisRandomGenerator.next", bytesPerOperation: 8, iterations: typedIterations) {
+            (try? generator.nextValue()) != nil
+        }
+        benchmark.measure(name: "QuantisRandomGenerator.Int.random", bytesPerOperation: 8, iterations: typedIterations) {
+            Int.random(in: 1...100, using: &generator) > 0
+        }
+
+        // MARK: Single versus multi-threaded access to the same device
+        for threadCount in threadCounts {
+            for readSize in [8, 4096] {
+                benchmark.measure(name: "QuantisRead.threads", bytesPerOperation: readSize,
+                                  iterations: iterationCount(for: readSize), threads: threadCount) {
+                    var local = [UInt8](repeating: 0, count: readSize)
+                    return local.withUnsafeMutableBytes {
+                        QuantisRead(device, deviceNumber, $0.baseAddress!, readSize) == Int32(readSize)
+                    }
+                }
+            }
+        }
+
+        let formatter = DateFormatter()
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.timeZone = TimeZone(identifier: "UTC")
+        formatter.dateFormat = "yyyy-MM-dd'T'HH:mm:ss'Z'"
+
+        let report = BenchmarkReport(deviceType: type,
+                                     deviceNumber: deviceNumber,
+                                     date: formatter.string(from: Date()),
+                                     results: benchmark.results)
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = .prettyPrinted
+        let json = try encoder.encode(report)
+
+        if let output = output {
+            try json.write(to: URL(fileURLWithPath: output))
+        } else {
+            FileHandle.standardOutput.write(json)
+            FileHandle.standardOutput.write("\n".data(using: .utf8)!)
+        }
+    }
+}
@@ -70,7 +70,7 @@ struct QuantisCLI: ParsableCommand {
     @Option(name: .short, help: "Amount of elements to generate")
     var count: Int?
     
-    @Option(name: .short, help: "Device Type: 1 - PCI-E, 2  - USB")
+    @Option(name: .short, help: "Device Type: 1 - PCI-E, 2  - USB, 4 - Simulator")
     var type: UInt32?
     
     @Option(name: .short, help: "Device Number")
@@ -82,6 +82,13 @@ struct QuantisCLI: ParsableCommand {
     @Option(name: [.short, .long], help: "Generate random binary data")
     var binary: Int?
     
+    @Option(name: [.short, .long], help:
+            """
+            Write -b <bytes> of random binary data to a file, without size limit.
+            Example: -b 4294967296 -o entropy.bin
+            """)
+    var output: String?
+    
     // TODO: DELETE ME
     @Flag(name: .long, help: "Test conformance to RandomNumberGenerator")
     var test: Bool = false
@@ -95,9 +102,15 @@ struct QuantisCLI: ParsableCommand {
         }
         
         if deviceInfo {
-            print("\nManufacturer: \(quantis.getDeviceInfo().manufacturer)\n")
-            print("Core version: \(quantis.getDeviceInfo().boardVersion)\n")
-            print("Serial number: \(quantis.getDeviceInfo().serialNumber)\n")
+            let info = try quantis.getDeviceInfo()
+            print("\nManufacturer: \(info.manufacturer)\n")
+            print("Core version: \(info.boardVersion)\n")
+            print("Serial number: \(info.serialNumber)\n")
+            print("Modules: \(info.modulesCount) (mask \(info.modulesMask), status \(info.modulesStatus), power \(info.modulesPower))\n")
+            print("Data rate: \(info.modulesDataRate) bytes/s\n")
+            if info.busDeviceId > 0 {
+                print("PCI bus/device: \(info.busDeviceId >> 8)/\(info.busDeviceId & 0xFF)\n")
+            }
             return
         }
         
@@ -186,6 +199,33 @@ struct QuantisCLI: ParsableCommand {
             }
         }
         
+        if let output = output {
+            guard let binary = binary, binary > 0 else {
+                return print("Please provide -b <bytes>")
+            }
+            
+            guard FileManager.default.createFile(atPath: output, contents: nil),
+                  let file = FileHandle(forWritingAtPath: output) else {
+                print("Cannot create file: \(output)")
+                throw ExitCode.failure
+            }
+            defer {
+                file.closeFile()
+            }
+            
+            // Each chunk is written while the device reads the next one
+            do {
+                try quantis.quantisReadStream(bytes: UInt64(binary)) { chunk in
+                    file.write(Data(chunk))
+                    return true
+                }
+                return
+            } catch {
+                print(error)
+                fatalError()
+            }
+        }
+        
         if test {
             if count != nil {
                 for _ in 0..<count! {
@@ -58,6 +58,251 @@
 
 #include "Conversion.h"
 
+/*
+ * Bulk conversion kernels. The best kernel supported by the CPU is selected
+ * at runtime on x86; NEON is always available on 64-bit ARM. All the kernels
+ * return exactly the same values as the scalar code, they only handle whole
+ * vectors and leave the tail of the arrays to it.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONVERSION_X86_KERNELS
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define CONVERSION_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+/* Exponent of 1.0, random bits in the significand give a value in [1.0, 2.0) */
+#define DOUBLE_ONE_EXPONENT 0x3FF0000000000000ull
+
+/* 2^-24, the weight of the least significant of the 24 bits of a float */
+#define FLOAT_01_SCALE (1.0f / 16777216.0f)
+
+/* A kernel converts whole vectors and returns the number of converted values */
+typedef size_t (*ConvertToDoubleArrayKernel)(const unsigned char *bytes, double *values, size_t count);
+typedef size_t (*ConvertToFloatArrayKernel)(const unsigned char *bytes, float *values, size_t count);
+
+#ifdef CONVERSION_X86_KERNELS
+
+__attribute__((target("sse2"))) static size_t ConvertToDoubleArraySse2(const unsigned char *bytes, double *values, size_t count)
+{
+  const __m128i exponent = _mm_set1_epi64x((long long)DOUBLE_ONE_EXPONENT);
+  const __m128d one = _mm_set1_pd(1.0);
+  size_t i;
+
+  for (i = 0; i + 2 <= count; i += 2)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(bytes + i * sizeof(double)));
+    v = _mm_or_si128(_mm_srli_epi64(v, 12), exponent);
+    _mm_storeu_pd(values + i, _mm_sub_pd(_mm_castsi128_pd(v), one));
+  }
+
+  return i;
+}
+
+__attribute__((target("sse2"))) static size_t ConvertToFloatArraySse2(const unsigned char *bytes, float *values, size_t count)
+{
+  const __m128 scale = _mm_set1_ps(FLOAT_01_SCALE);
+  size_t i;
+
+  for (i = 0; i + 4 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(bytes + i * sizeof(float)));
+    v = _mm_srli_epi32(v, 8);
+    _mm_storeu_ps(values + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t ConvertToDoubleArrayAvx2(const unsigned char *bytes, double *values, size_t count)
+{
+  const __m256i exponent = _mm256_set1_epi64x((long long)DOUBLE_ONE_EXPONENT);
+  const __m256d one = _mm256_set1_pd(1.0);
+  size_t i;
+
+  for (i = 0; i + 8 <= count; i += 8)
+  {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(bytes + i * sizeof(double)));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(bytes + (i + 4) * sizeof(double)));
+    v0 = _mm256_or_si256(_mm256_srli_epi64(v0, 12), exponent);
+    v1 = _mm256_or_si256(_mm256_srli_epi64(v1, 12), exponent);
+    _mm256_storeu_pd(values + i, _mm256_sub_pd(_mm256_castsi256_pd(v0), one));
+    _mm256_storeu_pd(values + i + 4, _mm256_sub_pd(_mm256_castsi256_pd(v1), one));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t ConvertToFloatArrayAvx2(const unsigned char *bytes, float *values, size_t count)
+{
+  const __m256 scale = _mm256_set1_ps(FLOAT_01_SCALE);
+  size_t i;
+
+  for (i = 0; i + 16 <= count; i += 16)
+  {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(bytes + i * sizeof(float)));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(bytes + (i + 8) * sizeof(float)));
+    v0 = _mm256_srli_epi32(v0, 8);
+    v1 = _mm256_srli_epi32(v1, 8);
+    _mm256_storeu_ps(values + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v0), scale));
+    _mm256_storeu_ps(values + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(v1), scale));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx512f"))) static size_t ConvertToDoubleArrayAvx512(const unsigned char *bytes, double *values, size_t count)
+{
+  const __m512i exponent = _mm512_set1_epi64((long long)DOUBLE_ONE_EXPONENT);
+  const __m512d one = _mm512_set1_pd(1.0);
+  size_t i;
+
+  for (i = 0; i + 8 <= count; i += 8)
+  {
+    __m512i v = _mm512_loadu_si512((const void *)(bytes + i * sizeof(double)));
+    v = _mm512_or_si512(_mm512_srli_epi64(v, 12), exponent);
+    _mm512_storeu_pd(values + i, _mm512_sub_pd(_mm512_castsi512_pd(v), one));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx512f"))) static size_t ConvertToFloatArrayAvx512(const unsigned char *bytes, float *values, size_t count)
+{
+  const __m512 scale = _mm512_set1_ps(FLOAT_01_SCALE);
+  size_t i;
+
+  for (i = 0; i + 16 <= count; i += 16)
+  {
+    __m512i v = _mm512_loadu_si512((const void *)(bytes + i * sizeof(float)));
+    v = _mm512_srli_epi32(v, 8);
+    _mm512_storeu_ps(values + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), scale));
+  }
+
+  return i;
+}
+
+#endif /* CONVERSION_X86_KERNELS */
+
+#ifdef CONVERSION_NEON_KERNELS
+
+static size_t ConvertToDoubleArrayNeon(const unsigned char *bytes, double *values, size_t count)
+{
+  const uint64x2_t exponent = vdupq_n_u64(DOUBLE_ONE_EXPONENT);
+  const float64x2_t one = vdupq_n_f64(1.0);
+  size_t i;
+
+  for (i = 0; i + 2 <= count; i += 2)
+  {
+    uint64x2_t v = vreinterpretq_u64_u8(vld1q_u8(bytes + i * sizeof(double)));
+    v = vorrq_u64(vshrq_n_u64(v, 12), exponent);
+    vst1q_f64(values + i, vsubq_f64(vreinterpretq_f64_u64(v), one));
+  }
+
+  return i;
+}
+
+static size_t ConvertToFloatArrayNeon(const unsigned char *bytes, float *values, size_t count)
+{
+  const float32x4_t scale = vdupq_n_f32(FLOAT_01_SCALE);
+  size_t i;
+
+  for (i = 0; i + 4 <= count; i += 4)
+  {
+    uint32x4_t v = vreinterpretq_u32_u8(vld1q_u8(bytes + i * sizeof(float)));
+    v = vshrq_n_u32(v, 8);
+    vst1q_f32(values + i, vmulq_f32(vcvtq_f32_u32(v), scale));
+  }
+
+  return i;
+}
+
+#endif /* CONVERSION_NEON_KERNELS */
+
+static size_t ConvertToDoubleArrayNone(const unsigned char *bytes, double *values, size_t count)
+{
+  (void)bytes;
+  (void)values;
+  (void)count;
+  return 0;
+}
+
+static size_t ConvertToFloatArrayNone(const unsigned char *bytes, float *values, size_t count)
+{
+  (void)bytes;
+  (void)values;
+  (void)count;
+  return 0;
+}
+
+#ifdef CONVERSION_X86_KERNELS
+/* Selected once, on first use */
+static ConvertToDoubleArrayKernel doubleArrayKernel = NULL;
+static ConvertToFloatArrayKernel floatArrayKernel = NULL;
+
+static void ConvertSelectKernels()
+{
+  ConvertToDoubleArrayKernel doubleKernel = ConvertToDoubleArrayNone;
+  ConvertToFloatArrayKernel floatKernel = ConvertToFloatArrayNone;
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+  {
+    doubleKernel = ConvertToDoubleArrayAvx512;
+    floatKernel = ConvertToFloatArrayAvx512;
+  }
+  else if (__builtin_cpu_supports("avx2"))
+  {
+    doubleKernel = ConvertToDoubleArrayAvx2;
+    floatKernel = ConvertToFloatArrayAvx2;
+  }
+  else if (__builtin_cpu_supports("sse2"))
+  {
+    doubleKernel = ConvertToDoubleArraySse2;
+    floatKernel = ConvertToFloatArraySse2;
+  }
+
+  /* Every thread selects the same kernels, so racing here is harmless */
+  __atomic_store_n(&floatArrayKernel, floatKernel, __ATOMIC_RELEASE);
+  __atomic_store_n(&doubleArrayKernel, doubleKernel, __ATOMIC_RELEASE);
+}
+#endif /* CONVERSION_X86_KERNELS */
+
+static ConvertToDoubleArrayKernel ConvertGetDoubleArrayKernel()
+{
+#if defined(CONVERSION_X86_KERNELS)
+  ConvertToDoubleArrayKernel kernel = __atomic_load_n(&doubleArrayKernel, __ATOMIC_ACQUIRE);
+  if (!kernel)
+  {
+    ConvertSelectKernels();
+    kernel = __atomic_load_n(&doubleArrayKernel, __ATOMIC_ACQUIRE);
+  }
+  return kernel;
+#elif defined(CONVERSION_NEON_KERNELS)
+  return ConvertToDoubleArrayNeon;
+#else
+  return ConvertToDoubleArrayNone;
+#endif
+}
+
+static ConvertToFloatArrayKernel ConvertGetFloatArrayKernel()
+{
+#if defined(CONVERSION_X86_KERNELS)
+  ConvertToFloatArrayKernel kernel = __atomic_load_n(&floatArrayKernel, __ATOMIC_ACQUIRE);
+  if (!kernel)
+  {
+    ConvertSelectKernels();
+    kernel = __atomic_load_n(&floatArrayKernel, __ATOMIC_ACQUIRE);
+  }
+  return kernel;
+#elif defined(CONVERSION_NEON_KERNELS)
+  return ConvertToFloatArrayNeon;
+#else
+  return ConvertToFloatArrayNone;
+#endif
+}
+
 double ConvertToDouble_01(const char *buffer)
 {
   uint64_t value;
@@ -86,6 +331,183 @@ short ConvertToShort(const char *buffer)
   return value;
 }
 
+void ConvertToDoubleArray_01(const void *buffer, double *values, size_t count)
+{
+  const unsigned char *bytes = (const unsigned char *)buffer;
+  size_t i = ConvertGetDoubleArrayKernel()(bytes, values, count);
+
+  /* Each value is read before being written, so buffer may alias values */
+  for (; i < count; ++i)
+  {
+    uint64_t value;
+    double result;
+    memcpy(&value, bytes + i * sizeof(value), sizeof(value));
+    value = (value >> 12) | DOUBLE_ONE_EXPONENT;
+    memcpy(&result, &value, sizeof(result));
+    values[i] = result - 1.0;
+  }
+}
+
+void ConvertToFloatArray_01(const void *buffer, float *values, size_t count)
+{
+  const unsigned char *bytes = (const unsigned char *)buffer;
+  size_t i = ConvertGetFloatArrayKernel()(bytes, values, count);
+
+  /* Each value is read before being written, so buffer may alias values */
+  for (; i < count; ++i)
+  {
+    uint32_t value;
+    memcpy(&value, bytes + i * sizeof(value), sizeof(value));
+    values[i] = (float)(int32_t)(value >> 8) * FLOAT_01_SCALE;
+  }
+}
+
+void ConvertToShortArray(const void *buffer, short *values, size_t count)
+{
+  memmove(values, buffer, count * sizeof(*values));
+}
+
+void ConvertToIntArray(const void *buffer, int *values, size_t count)
+{
+  memmove(values, buffer, count * sizeof(*values));
+}
+
+void ConvertToInt64Array(const void *buffer, int64_t *values, size_t count)
+{
+  memmove(values, buffer, count * sizeof(*values));
+}
+
+size_t ConvertToBoundedArray32(const void *buffer,
+                               size_t wordsCount,
+                               uint32_t range,
+                               uint32_t *values,
+                               size_t count,
+                               size_t *consumed)
+{
+  const unsigned char *bytes = (const unsigned char *)buffer;
+  uint32_t threshold = 0u;
+  int thresholdKnown = 0;
+  size_t filled = 0u;
+  size_t i;
+
+  if (range == 0u)
+  {
+    /* Every word is a valid value */
+    filled = (wordsCount < count) ? wordsCount : count;
+    memmove(values, buffer, filled * sizeof(*values));
+    if (consumed != NULL)
+    {
+      *consumed = filled;
+    }
+    return filled;
+  }
+
+  for (i = 0u; (i < wordsCount) && (filled < count); ++i)
+  {
+    uint32_t word;
+    uint64_t product;
+    memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+
+    product = (uint64_t)word * range;
+    if ((uint32_t)product < range)
+    {
+      /* Only these few words can be biased, 2^32 mod range is computed once */
+      if (!thresholdKnown)
+      {
+        threshold = (uint32_t)(0u - range) % range;
+        thresholdKnown = 1;
+      }
+      if ((uint32_t)product < threshold)
+      {
+        continue;
+      }
+    }
+    values[filled++] = (uint32_t)(product >> 32);
+  }
+
+  if (consumed != NULL)
+  {
+    *consumed = i;
+  }
+  return filled;
+}
+
+size_t ConvertToBoundedArray16(const void *buffer,
+                               size_t wordsCount,
+                               uint16_t range,
+                               uint16_t *values,
+                               size_t count,
+                               size_t *consumed)
+{
+  const unsigned char *bytes = (const unsigned char *)buffer;
+  uint16_t threshold = 0u;
+  int thresholdKnown = 0;
+  size_t filled = 0u;
+  size_t i;
+
+  if (range == 0u)
+  {
+    filled = (wordsCount < count) ? wordsCount : count;
+    memmove(values, buffer, filled * sizeof(*values));
+    if (consumed != NULL)
+    {
+      *consumed = filled;
+    }
+    return filled;
+  }
+
+  /* See ConvertToBoundedArray32 */
+  for (i = 0u; (i < wordsCount) && (filled < count); ++i)
+  {
+    uint16_t word;
+    uint32_t product;
+    memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+
+    product = (uint32_t)word * range;
+    if ((uint16_t)product < range)
+    {
+      if (!thresholdKnown)
+      {
+        threshold = (uint16_t)((0x10000u - range) % range);
+        thresholdKnown = 1;
+      }
+      if ((uint16_t)product < threshold)
+      {
+        continue;
+      }
+    }
+    values[filled++] = (uint16_t)(product >> 16);
+  }
+
+  if (consumed != NULL)
+  {
+    *consumed = i;
+  }
+  return filled;
+}
+
+void ScaleDoubleArray(double *values, size_t count, double min, double max)
+{
+  const double range = max - min;
+  size_t i;
+
+  for (i = 0; i < count; ++i)
+  {
+    values[i] = values[i] * range + min;
+  }
+}
+
+void ScaleFloatArray(float *values, size_t count, float min, float max)
+{
+  const float range = max - min;
+  size_t i;
+
+  for (i = 0; i < count; ++i)
+  {
+    values[i] = values[i] * range + min;
+  }
+}
+
 char ConvertHexaToByte(char c)
 {
   if ('0' <= c && c <= '9')
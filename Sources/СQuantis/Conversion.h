@@ -97,6 +97,120 @@ extern "C"
    */
   DLL_EXPORT short ConvertToShort(const char *buffer);
 
+  /**
+   * Convert random bytes to double values between 0.0 (inclusive) and 1.0
+   * (exclusive).
+   * @param buffer the buffer (count * sizeof(double) long) to convert. It may
+   * be the same memory as values, in which case the conversion is done in place.
+   * @param values the array of count double values to fill.
+   * @param count the number of values to convert.
+   * @note the 52 most significant bits of each value fill the significand of
+   * a double in [1.0, 2.0), from which 1.0 is subtracted. The conversion uses
+   * AVX-512, AVX2, SSE2 or NEON when the CPU supports them.
+   */
+  DLL_EXPORT void ConvertToDoubleArray_01(const void *buffer, double *values, size_t count);
+
+  /**
+   * Convert random bytes to float values between 0.0 (inclusive) and 1.0
+   * (exclusive).
+   * @param buffer the buffer (count * sizeof(float) long) to convert. It may
+   * be the same memory as values, in which case the conversion is done in place.
+   * @param values the array of count float values to fill.
+   * @param count the number of values to convert.
+   * @note only the 24 most significant bits of each value are used, so that
+   * every value is exactly representable and below 1.0. The conversion uses
+   * AVX-512, AVX2, SSE2 or NEON when the CPU supports them.
+   */
+  DLL_EXPORT void ConvertToFloatArray_01(const void *buffer, float *values, size_t count);
+
+  /**
+   * Convert random bytes to short values (in host byte order).
+   * @param buffer the buffer (count * sizeof(short) long) to convert. It may
+   * overlap values.
+   * @param values the array of count short values to fill.
+   * @param count the number of values to convert.
+   */
+  DLL_EXPORT void ConvertToShortArray(const void *buffer, short *values, size_t count);
+
+  /**
+   * Convert random bytes to int values (in host byte order).
+   * @param buffer the buffer (count * sizeof(int) long) to convert. It may
+   * overlap values.
+   * @param values the array of count int values to fill.
+   * @param count the number of values to convert.
+   */
+  DLL_EXPORT void ConvertToIntArray(const void *buffer, int *values, size_t count);
+
+  /**
+   * Convert random bytes to 64-bit integer values (in host byte order).
+   * @param buffer the buffer (count * sizeof(int64_t) long) to convert. It may
+   * overlap values.
+   * @param values the array of count 64-bit values to fill.
+   * @param count the number of values to convert.
+   */
+  DLL_EXPORT void ConvertToInt64Array(const void *buffer, int64_t *values, size_t count);
+
+  /**
+   * Convert random 32-bit words to unbiased integers in [0, range), with the
+   * nearly divisionless multiply-shift method: the high half of word * range
+   * is the result, and a word is rejected only when the low half falls below
+   * 2^32 mod range. That threshold is computed at most once per call, so most
+   * values cost one multiplication.
+   * @param buffer the buffer of wordsCount random 32-bit words to convert. It
+   * may start at values, the results never overtake the words still to read.
+   * @param wordsCount the number of words in buffer.
+   * @param range the number of possible values, 0 meaning 2^32.
+   * @param values the array of at most count values to fill.
+   * @param count the maximal number of values to fill.
+   * @param consumed if not NULL, receives the number of words used.
+   * @return the number of values filled, lower than count only when the
+   * words of buffer were exhausted.
+   */
+  DLL_EXPORT size_t ConvertToBoundedArray32(const void *buffer,
+                                            size_t wordsCount,
+                                            uint32_t range,
+                                            uint32_t *values,
+                                            size_t count,
+                                            size_t *consumed);
+
+  /**
+   * Convert random 16-bit words to unbiased integers in [0, range).
+   * @param buffer the buffer of wordsCount random 16-bit words to convert.
+   * @param wordsCount the number of words in buffer.
+   * @param range the number of possible values, 0 meaning 2^16.
+   * @param values the array of at most count values to fill.
+   * @param count the maximal number of values to fill.
+   * @param consumed if not NULL, receives the number of words used.
+   * @return the number of values filled.
+   * @see ConvertToBoundedArray32
+   */
+  DLL_EXPORT size_t ConvertToBoundedArray16(const void *buffer,
+                                            size_t wordsCount,
+                                            uint16_t range,
+                                            uint16_t *values,
+                                            size_t count,
+                                            size_t *consumed);
+
+  /**
+   * Scale double values between 0.0 (inclusive) and 1.0 (exclusive) to be
+   * between min (inclusive) and max (exclusive), in place.
+   * @param values the array of count double values to scale.
+   * @param count the number of values to scale.
+   * @param min the minimal value.
+   * @param max the maximal value.
+   */
+  DLL_EXPORT void ScaleDoubleArray(double *values, size_t count, double min, double max);
+
+  /**
+   * Scale float values between 0.0 (inclusive) and 1.0 (exclusive) to be
+   * between min (inclusive) and max (exclusive), in place.
+   * @param values the array of count float values to scale.
+   * @param count the number of values to scale.
+   * @param min the minimal value.
+   * @param max the maximal value.
+   */
+  DLL_EXPORT void ScaleFloatArray(float *values, size_t count, float min, float max);
+
   /**
    * Convert a hexadecimal character to a byte.
    * @param c the character to convert.
@@ -0,0 +1,386 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Quantis.h"
+#include "Quantis_Internal.h"
+
+/*
+ * Minimal share (in bytes) of a device: smaller requests are not worth being
+ * split across several devices.
+ */
+#define QUANTIS_AGGREGATE_MIN_SHARE 4096
+
+/* A device of the aggregate and the worker thread reading it */
+typedef struct QuantisAggregateWorker
+{
+  QuantisAggregate *aggregate;
+  QuantisDeviceType deviceType;
+  unsigned int deviceNumber;
+
+  /* Weight of the device when sharing requests */
+  unsigned long weight;
+
+  pthread_t thread;
+  int started;
+
+  /* Current job, protected by the lock of the aggregate */
+  unsigned char *buffer;
+  size_t size;
+  int pending;
+  int result;
+} QuantisAggregateWorker;
+
+struct QuantisAggregate
+{
+  QuantisAggregateWorker *workers;
+  unsigned int workersCount;
+  unsigned long totalWeight;
+
+  /* Serializes requests, a request is shared by all workers */
+  pthread_mutex_t requestLock;
+
+  pthread_mutex_t lock;
+  pthread_cond_t workCond;
+  pthread_cond_t doneCond;
+  unsigned int pendingCount;
+  int running;
+};
+
+static void *QuantisAggregateWorkerThread(void *arg)
+{
+  QuantisAggregateWorker *worker = (QuantisAggregateWorker *)arg;
+  QuantisAggregate *aggregate = worker->aggregate;
+
+  pthread_mutex_lock(&aggregate->lock);
+  for (;;)
+  {
+    QuantisDeviceHandle *deviceHandle = NULL;
+    int result;
+
+    while (aggregate->running && !worker->pending)
+    {
+      pthread_cond_wait(&aggregate->workCond, &aggregate->lock);
+    }
+    if (!aggregate->running)
+    {
+      break;
+    }
+    pthread_mutex_unlock(&aggregate->lock);
+
+    /*
+     * Reads the share of the device directly into the caller's buffer. The
+     * handle comes from the cache, so that the device stays usable through
+     * the device-number functions between requests.
+     */
+    result = QuantisAcquireInternal(worker->deviceType, worker->deviceNumber, &deviceHandle);
+    if (result >= 0)
+    {
+      result = QuantisReadHandled(deviceHandle, worker->buffer, worker->size);
+      if ((result >= 0) && ((size_t)result != worker->size))
+      {
+        result = QUANTIS_ERROR_IO;
+      }
+      QuantisReleaseInternal(deviceHandle, result);
+    }
+
+    pthread_mutex_lock(&aggregate->lock);
+    worker->result = result;
+    worker->pending = 0;
+    aggregate->pendingCount--;
+    if (aggregate->pendingCount == 0u)
+    {
+      pthread_cond_signal(&aggregate->doneCond);
+    }
+  }
+  pthread_mutex_unlock(&aggregate->lock);
+
+  return NULL;
+}
+
+/* Acquires all the devices of type and adds them to the aggregate */
+static int QuantisAggregateOpenDevices(QuantisAggregate *aggregate,
+                                       QuantisDeviceType deviceType,
+                                       QuantisAggregateShareMode shareMode)
+{
+  int count = QuantisCount(deviceType);
+  int deviceNumber;
+
+  for (deviceNumber = 0; deviceNumber < count; deviceNumber++)
+  {
+    QuantisAggregateWorker *worker = &aggregate->workers[aggregate->workersCount];
+    QuantisDeviceHandle *deviceHandle = NULL;
+    int dataRate;
+
+    if (aggregate->workersCount >= 2u * MAX_QUANTIS_DEVICE)
+    {
+      break;
+    }
+
+    /* Devices that cannot be opened (e.g. used by another process) are skipped */
+    if (QuantisAcquireInternal(deviceType, (unsigned int)deviceNumber, &deviceHandle) < 0)
+    {
+      continue;
+    }
+
+    worker->aggregate = aggregate;
+    worker->deviceType = deviceType;
+    worker->deviceNumber = (unsigned int)deviceNumber;
+    worker->weight = 1u;
+    if (shareMode == QUANTIS_SHARE_WEIGHTED)
+    {
+      dataRate = deviceHandle->ops->GetModulesDataRate(deviceHandle);
+      if (dataRate <= 0)
+      {
+        /* No module enabled: the device is not read at all */
+        dataRate = 0;
+      }
+      worker->weight = (unsigned long)dataRate;
+    }
+    QuantisReleaseInternal(deviceHandle, QUANTIS_SUCCESS);
+
+    aggregate->totalWeight += worker->weight;
+    aggregate->workersCount++;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisAggregateOpen(QuantisAggregateShareMode shareMode,
+                         QuantisAggregate **aggregate)
+{
+  QuantisAggregate *_aggregate = NULL;
+  unsigned int i;
+
+  if (!aggregate ||
+      ((shareMode != QUANTIS_SHARE_FAIR) && (shareMode != QUANTIS_SHARE_WEIGHTED)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *aggregate = NULL;
+
+  _aggregate = (QuantisAggregate *)calloc(1u, sizeof(QuantisAggregate));
+  if (!_aggregate)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  _aggregate->workers = (QuantisAggregateWorker *)calloc(2u * MAX_QUANTIS_DEVICE,
+                                                         sizeof(QuantisAggregateWorker));
+  if (!_aggregate->workers)
+  {
+    free(_aggregate);
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  pthread_mutex_init(&_aggregate->requestLock, NULL);
+  pthread_mutex_init(&_aggregate->lock, NULL);
+  pthread_cond_init(&_aggregate->workCond, NULL);
+  pthread_cond_init(&_aggregate->doneCond, NULL);
+  _aggregate->running = 1;
+
+#ifndef DISABLE_QUANTIS_PCI
+  QuantisAggregateOpenDevices(_aggregate, QUANTIS_DEVICE_PCI, shareMode);
+#endif /* DISABLE_QUANTIS_PCI */
+
+#ifndef DISABLE_QUANTIS_USB
+  QuantisAggregateOpenDevices(_aggregate, QUANTIS_DEVICE_USB, shareMode);
+#endif /* DISABLE_QUANTIS_USB */
+
+  if ((_aggregate->workersCount == 0u) || (_aggregate->totalWeight == 0u))
+  {
+    QuantisAggregateClose(_aggregate);
+    return QUANTIS_ERROR_NO_DEVICE;
+  }
+
+  /* Starts a worker per device */
+  for (i = 0u; i < _aggregate->workersCount; i++)
+  {
+    QuantisAggregateWorker *worker = &_aggregate->workers[i];
+    if (pthread_create(&worker->thread, NULL, QuantisAggregateWorkerThread, worker) != 0)
+    {
+      QuantisAggregateClose(_aggregate);
+      return QUANTIS_ERROR_OTHER;
+    }
+    worker->started = 1;
+  }
+
+  *aggregate = _aggregate;
+
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisAggregateClose(QuantisAggregate *aggregate)
+{
+  unsigned int i;
+
+  if (!aggregate)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&aggregate->lock);
+  aggregate->running = 0;
+  pthread_cond_broadcast(&aggregate->workCond);
+  pthread_mutex_unlock(&aggregate->lock);
+
+  for (i = 0u; i < aggregate->workersCount; i++)
+  {
+    QuantisAggregateWorker *worker = &aggregate->workers[i];
+    if (worker->started)
+    {
+      pthread_join(worker->thread, NULL);
+    }
+  }
+
+  pthread_cond_destroy(&aggregate->doneCond);
+  pthread_cond_destroy(&aggregate->workCond);
+  pthread_mutex_destroy(&aggregate->lock);
+  pthread_mutex_destroy(&aggregate->requestLock);
+  free(aggregate->workers);
+  free(aggregate);
+}
+
+int QuantisAggregateCount(QuantisAggregate *aggregate)
+{
+  if (!aggregate)
+  {
+    return 0;
+  }
+
+  return (int)aggregate->workersCount;
+}
+
+int QuantisAggregateRead(QuantisAggregate *aggregate,
+                         void *buffer,
+                         size_t size)
+{
+  unsigned char *output = (unsigned char *)buffer;
+  unsigned long remainingWeight;
+  size_t remainingSize;
+  unsigned int i;
+  int result = (int)size;
+
+  if (!aggregate)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (size == 0u)
+  {
+    return 0;
+  }
+  else if (size > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  pthread_mutex_lock(&aggregate->requestLock);
+  pthread_mutex_lock(&aggregate->lock);
+
+  /*
+   * Shares the request according to the weights of the devices. Each share
+   * is computed on what is left, so that rounding never loses a byte.
+   */
+  remainingWeight = aggregate->totalWeight;
+  remainingSize = size;
+  for (i = 0u; (i < aggregate->workersCount) && (remainingSize > 0u); i++)
+  {
+    QuantisAggregateWorker *worker = &aggregate->workers[i];
+    size_t share;
+
+    if (worker->weight == 0u)
+    {
+      continue;
+    }
+
+    share = (size_t)(((double)remainingSize * worker->weight) / remainingWeight);
+    if (share < QUANTIS_AGGREGATE_MIN_SHARE)
+    {
+      share = QUANTIS_AGGREGATE_MIN_SHARE;
+    }
+    if ((share > remainingSize) || (remainingWeight == worker->weight))
+    {
+      share = remainingSize;
+    }
+    remainingWeight -= worker->weight;
+
+    worker->buffer = output + (size - remainingSize);
+    worker->size = share;
+    worker->pending = 1;
+    aggregate->pendingCount++;
+    remainingSize -= share;
+  }
+  pthread_cond_broadcast(&aggregate->workCond);
+
+  /* Waits for all the shares */
+  while (aggregate->pendingCount > 0u)
+  {
+    pthread_cond_wait(&aggregate->doneCond, &aggregate->lock);
+  }
+
+  for (i = 0u; i < aggregate->workersCount; i++)
+  {
+    QuantisAggregateWorker *worker = &aggregate->workers[i];
+    if ((worker->size > 0u) && (worker->result < 0) && (result >= 0))
+    {
+      result = worker->result;
+    }
+    worker->size = 0u;
+  }
+
+  pthread_mutex_unlock(&aggregate->lock);
+  pthread_mutex_unlock(&aggregate->requestLock);
+
+  return result;
+}
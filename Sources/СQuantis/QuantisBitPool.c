@@ -0,0 +1,403 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Quantis.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define QUANTIS_BITPOOL_PDEP
+#include <immintrin.h>
+#endif
+
+/* Default number of bytes read from the device at once */
+#define QUANTIS_BITPOOL_DEFAULT_BUFFER_SIZE 4096u
+
+/* Low bit of each byte of a 64-bit word */
+#define QUANTIS_BITPOOL_BYTES_LSB UINT64_C(0x0101010101010101)
+
+struct QuantisBitPool
+{
+  QuantisDeviceHandle *deviceHandle;
+
+  /* Random bytes read from the device */
+  unsigned char *buffer;
+  size_t bufferSize;
+  size_t bufferPosition;
+
+  /* Random bits not used yet, the next ones being the most significant */
+  uint64_t bits;
+  unsigned int bitsCount;
+
+  unsigned long long bitsRead;
+  unsigned long long bitsConsumed;
+};
+
+/*
+ * Spreads the 8 values of bitsPerValue bits packed in the low bits of packed
+ * over the 8 bytes of the result, the first value in the lowest byte.
+ */
+typedef uint64_t (*QuantisBitPoolUnpackFunction)(uint64_t packed, unsigned int bitsPerValue);
+
+static uint64_t QuantisBitPoolUnpackShifts(uint64_t packed, unsigned int bitsPerValue)
+{
+  const uint64_t mask = (UINT64_C(1) << bitsPerValue) - 1u;
+  uint64_t result = 0u;
+  unsigned int i;
+
+  for (i = 0u; i < 8u; i++)
+  {
+    result |= ((packed >> (i * bitsPerValue)) & mask) << (i * 8u);
+  }
+
+  return result;
+}
+
+#ifdef QUANTIS_BITPOOL_PDEP
+__attribute__((target("bmi2"))) static uint64_t QuantisBitPoolUnpackPdep(uint64_t packed, unsigned int bitsPerValue)
+{
+  /* Low bitsPerValue bits of each byte */
+  const uint64_t mask = QUANTIS_BITPOOL_BYTES_LSB * ((1u << bitsPerValue) - 1u);
+  return _pdep_u64(packed, mask);
+}
+
+static QuantisBitPoolUnpackFunction unpackFunction = NULL;
+#endif
+
+static QuantisBitPoolUnpackFunction QuantisBitPoolGetUnpackFunction()
+{
+#ifdef QUANTIS_BITPOOL_PDEP
+  QuantisBitPoolUnpackFunction function = __atomic_load_n(&unpackFunction, __ATOMIC_ACQUIRE);
+  if (function == NULL)
+  {
+    __builtin_cpu_init();
+
+    /* pdep is microcoded, and slower than shifts, before Zen 3 */
+    if (__builtin_cpu_supports("bmi2") &&
+        !__builtin_cpu_is("znver1") &&
+        !__builtin_cpu_is("znver2"))
+    {
+      function = QuantisBitPoolUnpackPdep;
+    }
+    else
+    {
+      function = QuantisBitPoolUnpackShifts;
+    }
+    __atomic_store_n(&unpackFunction, function, __ATOMIC_RELEASE);
+  }
+  return function;
+#else
+  return QuantisBitPoolUnpackShifts;
+#endif
+}
+
+static unsigned int QuantisBitPoolPopCount(uint64_t value)
+{
+#ifdef __GNUC__
+  return (unsigned int)__builtin_popcountll(value);
+#else
+  value = value - ((value >> 1) & UINT64_C(0x5555555555555555));
+  value = (value & UINT64_C(0x3333333333333333)) + ((value >> 2) & UINT64_C(0x3333333333333333));
+  value = (value + (value >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+  return (unsigned int)((value * QUANTIS_BITPOOL_BYTES_LSB) >> 56);
+#endif
+}
+
+/* Loads the next word of the buffer, reading the device when it is empty */
+static int QuantisBitPoolRefill(QuantisBitPool *pool)
+{
+  if (pool->bufferPosition >= pool->bufferSize)
+  {
+    int result = QuantisReadHandled(pool->deviceHandle, pool->buffer, pool->bufferSize);
+    if (result < 0)
+    {
+      return result;
+    }
+    else if ((size_t)result != pool->bufferSize)
+    {
+      return QUANTIS_ERROR_IO;
+    }
+    pool->bufferPosition = 0u;
+    pool->bitsRead += (unsigned long long)pool->bufferSize * 8u;
+  }
+
+  memcpy(&pool->bits, pool->buffer + pool->bufferPosition, sizeof(pool->bits));
+  pool->bufferPosition += sizeof(pool->bits);
+  pool->bitsCount = 64u;
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Takes count (0 to 64) bits, returned in the low bits of value */
+static int QuantisBitPoolTake(QuantisBitPool *pool, unsigned int count, uint64_t *value)
+{
+  uint64_t result = 0u;
+  unsigned int missing = count;
+
+  while (missing > 0u)
+  {
+    unsigned int taken;
+
+    if (pool->bitsCount == 0u)
+    {
+      int error = QuantisBitPoolRefill(pool);
+      if (error < 0)
+      {
+        return error;
+      }
+    }
+
+    taken = (missing < pool->bitsCount) ? missing : pool->bitsCount;
+    if (taken == 64u)
+    {
+      result = pool->bits;
+      pool->bits = 0u;
+    }
+    else
+    {
+      result = (result << taken) | (pool->bits >> (64u - taken));
+      pool->bits <<= taken;
+    }
+    pool->bitsCount -= taken;
+    missing -= taken;
+  }
+
+  pool->bitsConsumed += count;
+  *value = result;
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisBitPoolCreate(QuantisDeviceHandle *deviceHandle,
+                         size_t bufferSize,
+                         QuantisBitPool **pool)
+{
+  QuantisBitPool *newPool = NULL;
+
+  if (pool == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *pool = NULL;
+
+  if (deviceHandle == NULL)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (bufferSize == 0u)
+  {
+    bufferSize = QUANTIS_BITPOOL_DEFAULT_BUFFER_SIZE;
+  }
+
+  /* The buffer is consumed by 64-bit words */
+  bufferSize = (bufferSize + sizeof(uint64_t) - 1u) & ~(sizeof(uint64_t) - 1u);
+  if (bufferSize > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  newPool = (QuantisBitPool *)calloc(1u, sizeof(QuantisBitPool));
+  if (newPool == NULL)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  newPool->buffer = (unsigned char *)malloc(bufferSize);
+  if (newPool->buffer == NULL)
+  {
+    free(newPool);
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+  newPool->deviceHandle = deviceHandle;
+  newPool->bufferSize = bufferSize;
+  newPool->bufferPosition = bufferSize;
+
+  *pool = newPool;
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisBitPoolDestroy(QuantisBitPool *pool)
+{
+  if (pool == NULL)
+  {
+    return;
+  }
+
+  /* The device handle belongs to the caller */
+  free(pool->buffer);
+  free(pool);
+}
+
+int QuantisBitPoolTakeBits(QuantisBitPool *pool,
+                           unsigned int count,
+                           unsigned long long *bits)
+{
+  uint64_t value;
+  int result;
+
+  if ((pool == NULL) || (bits == NULL) || (count > 64u))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  result = QuantisBitPoolTake(pool, count, &value);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  *bits = value;
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisBitPoolReadValues(QuantisBitPool *pool,
+                             unsigned int bitsPerValue,
+                             unsigned char *values,
+                             size_t count)
+{
+  QuantisBitPoolUnpackFunction unpack;
+  uint64_t packed;
+  size_t i = 0u;
+  int result;
+
+  if ((pool == NULL) || (bitsPerValue < 1u) || (bitsPerValue > 8u) ||
+      ((values == NULL) && (count > 0u)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* 8 values are taken at once and spread over 8 bytes */
+  unpack = QuantisBitPoolGetUnpackFunction();
+  for (; i + 8u <= count; i += 8u)
+  {
+    uint64_t unpacked;
+
+    result = QuantisBitPoolTake(pool, 8u * bitsPerValue, &packed);
+    if (result < 0)
+    {
+      return result;
+    }
+
+    unpacked = unpack(packed, bitsPerValue);
+    memcpy(values + i, &unpacked, sizeof(unpacked));
+  }
+
+  for (; i < count; i++)
+  {
+    result = QuantisBitPoolTake(pool, bitsPerValue, &packed);
+    if (result < 0)
+    {
+      return result;
+    }
+    values[i] = (unsigned char)packed;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisBitPoolCountOnes(QuantisBitPool *pool,
+                            size_t bitsCount,
+                            size_t *ones)
+{
+  uint64_t bits;
+  size_t count = 0u;
+  int result;
+
+  if ((pool == NULL) || (ones == NULL))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  for (; bitsCount >= 64u; bitsCount -= 64u)
+  {
+    result = QuantisBitPoolTake(pool, 64u, &bits);
+    if (result < 0)
+    {
+      return result;
+    }
+    count += QuantisBitPoolPopCount(bits);
+  }
+
+  result = QuantisBitPoolTake(pool, (unsigned int)bitsCount, &bits);
+  if (result < 0)
+  {
+    return result;
+  }
+  count += QuantisBitPoolPopCount(bits);
+
+  *ones = count;
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisBitPoolGetStats(const QuantisBitPool *pool,
+                           unsigned long long *bitsRead,
+                           unsigned long long *bitsConsumed)
+{
+  if (pool == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  if (bitsRead != NULL)
+  {
+    *bitsRead = pool->bitsRead;
+  }
+  if (bitsConsumed != NULL)
+  {
+    *bitsConsumed = pool->bitsConsumed;
+  }
+
+  return QUANTIS_SUCCESS;
+}
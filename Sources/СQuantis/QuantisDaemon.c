@@ -0,0 +1,340 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Quantis.h"
+
+/*
+ * Number of requests sent before reading their responses. The requests of a
+ * window always fit in the socket buffer, so the client never blocks on
+ * sending while the daemon waits for it to read responses.
+ */
+#define QUANTIS_DAEMON_PIPELINE_DEPTH 64u
+
+/* A daemon exiting must not kill the client with SIGPIPE */
+#ifdef MSG_NOSIGNAL
+#define QUANTIS_DAEMON_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define QUANTIS_DAEMON_SEND_FLAGS 0
+#endif
+
+struct QuantisDaemonClient
+{
+  int socket;
+
+  /* Set once a request or response was cut, the connection is then unusable */
+  int broken;
+};
+
+/* Sends size bytes, retrying on interruptions and partial writes */
+static int QuantisDaemonSend(QuantisDaemonClient *client, const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+
+  while (size > 0u)
+  {
+    ssize_t sent = send(client->socket, bytes, size, QUANTIS_DAEMON_SEND_FLAGS);
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      client->broken = 1;
+      return QUANTIS_ERROR_IO;
+    }
+    bytes += sent;
+    size -= (size_t)sent;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Receives exactly size bytes */
+static int QuantisDaemonReceive(QuantisDaemonClient *client, void *data, size_t size)
+{
+  unsigned char *bytes = (unsigned char *)data;
+
+  while (size > 0u)
+  {
+    ssize_t received = recv(client->socket, bytes, size, 0);
+    if (received < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      client->broken = 1;
+      return QUANTIS_ERROR_IO;
+    }
+    else if (received == 0)
+    {
+      /* The daemon closed the connection */
+      client->broken = 1;
+      return QUANTIS_ERROR_IO;
+    }
+    bytes += received;
+    size -= (size_t)received;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Receives the response to a request of size bytes into buffer */
+static int QuantisDaemonReceiveResponse(QuantisDaemonClient *client, void *buffer, size_t size)
+{
+  QuantisDaemonResponse response;
+  int result;
+
+  result = QuantisDaemonReceive(client, &response, sizeof(response));
+  if (result < 0)
+  {
+    return result;
+  }
+
+  /* Errors come without data, the connection stays usable */
+  if (response.result < 0)
+  {
+    return response.result;
+  }
+  else if ((size_t)response.result != size)
+  {
+    client->broken = 1;
+    return QUANTIS_ERROR_IO;
+  }
+
+  result = QuantisDaemonReceive(client, buffer, size);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  return response.result;
+}
+
+int QuantisDaemonConnect(const char *socketPath,
+                         QuantisDaemonClient **client)
+{
+  QuantisDaemonClient *newClient = NULL;
+  struct sockaddr_un address;
+
+  if (client == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *client = NULL;
+
+  if (socketPath == NULL)
+  {
+    socketPath = QUANTIS_DAEMON_DEFAULT_SOCKET;
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address.sun_path))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  strcpy(address.sun_path, socketPath);
+
+  newClient = (QuantisDaemonClient *)malloc(sizeof(QuantisDaemonClient));
+  if (newClient == NULL)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  newClient->broken = 0;
+  newClient->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (newClient->socket < 0)
+  {
+    free(newClient);
+    return QUANTIS_ERROR_IO;
+  }
+
+#ifdef SO_NOSIGPIPE
+  {
+    int noSigPipe = 1;
+    setsockopt(newClient->socket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+  }
+#endif
+
+  if (connect(newClient->socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+  {
+    int error = ((errno == ENOENT) || (errno == ECONNREFUSED)) ? QUANTIS_ERROR_NO_DEVICE : QUANTIS_ERROR_IO;
+    close(newClient->socket);
+    free(newClient);
+    return error;
+  }
+
+  *client = newClient;
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisDaemonClose(QuantisDaemonClient *client)
+{
+  if (client == NULL)
+  {
+    return;
+  }
+
+  close(client->socket);
+  free(client);
+}
+
+int QuantisDaemonRead(QuantisDaemonClient *client,
+                      void *buffer,
+                      size_t size)
+{
+  QuantisDaemonRequest request;
+  int result;
+
+  if ((client == NULL) || client->broken)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (size > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  if ((buffer == NULL) && (size > 0u))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  request.opcode = QUANTIS_DAEMON_OPCODE_READ;
+  request.size = (unsigned int)size;
+  result = QuantisDaemonSend(client, &request, sizeof(request));
+  if (result < 0)
+  {
+    return result;
+  }
+
+  return QuantisDaemonReceiveResponse(client, buffer, size);
+}
+
+int QuantisDaemonReadBatch(QuantisDaemonClient *client,
+                           void *const *buffers,
+                           const size_t *sizes,
+                           size_t count)
+{
+  QuantisDaemonRequest requests[QUANTIS_DAEMON_PIPELINE_DEPTH];
+  size_t first;
+  size_t i;
+  int error = QUANTIS_SUCCESS;
+
+  if ((client == NULL) || client->broken)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if ((count > 0u) && ((buffers == NULL) || (sizes == NULL)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  for (i = 0u; i < count; i++)
+  {
+    if (sizes[i] > QUANTIS_MAX_READ_SIZE)
+    {
+      return QUANTIS_ERROR_INVALID_READ_SIZE;
+    }
+    if ((buffers[i] == NULL) && (sizes[i] > 0u))
+    {
+      return QUANTIS_ERROR_INVALID_PARAMETER;
+    }
+  }
+
+  for (first = 0u; first < count; first += QUANTIS_DAEMON_PIPELINE_DEPTH)
+  {
+    size_t windowCount = count - first;
+    int result;
+
+    if (windowCount > QUANTIS_DAEMON_PIPELINE_DEPTH)
+    {
+      windowCount = QUANTIS_DAEMON_PIPELINE_DEPTH;
+    }
+
+    /* Sends the whole window at once */
+    for (i = 0u; i < windowCount; i++)
+    {
+      requests[i].opcode = QUANTIS_DAEMON_OPCODE_READ;
+      requests[i].size = (unsigned int)sizes[first + i];
+    }
+    result = QuantisDaemonSend(client, requests, windowCount * sizeof(requests[0]));
+    if (result < 0)
+    {
+      return result;
+    }
+
+    /* Every response is received to keep the connection in sync */
+    for (i = 0u; i < windowCount; i++)
+    {
+      result = QuantisDaemonReceiveResponse(client, buffers[first + i], sizes[first + i]);
+      if (client->broken)
+      {
+        return QUANTIS_ERROR_IO;
+      }
+      else if ((result < 0) && (error == QUANTIS_SUCCESS))
+      {
+        error = result;
+      }
+    }
+  }
+
+  return error;
+}
@@ -0,0 +1,502 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* pthread_setaffinity_np, CPU_SET and MAP_HUGETLB */
+#define _GNU_SOURCE
+#endif
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Quantis.h"
+#include "Quantis_Internal.h"
+
+/* Size of transparent hugepages, used to align buffers when they are enabled */
+#define QUANTIS_MEMORY_THP_SIZE (2 * 1024 * 1024)
+
+/* Highest NUMA node buffers can be bound to */
+#define QUANTIS_MEMORY_MAX_NUMA_NODE 1023
+
+/* From <linux/mempolicy.h>, which is not installed everywhere */
+#define QUANTIS_MPOL_PREFERRED 1
+
+/* Memory mode used by QuantisBufferAlloc */
+static atomic_int QuantisMemoryModeValue = QUANTIS_MEMORY_DEFAULT;
+
+static size_t QuantisMemoryRoundUp(size_t size, size_t alignment)
+{
+  return ((size + alignment - 1u) / alignment) * alignment;
+}
+
+#ifdef __linux__
+
+/* Returns the size of the default hugepage of the system or 0 if unknown */
+static size_t QuantisMemoryHugePageSize()
+{
+  static atomic_size_t hugePageSize = 0u;
+  size_t size = atomic_load(&hugePageSize);
+  FILE *file = NULL;
+  char line[128];
+
+  if (size != 0u)
+  {
+    return size;
+  }
+
+  file = fopen("/proc/meminfo", "r");
+  if (!file)
+  {
+    return 0u;
+  }
+
+  while (fgets(line, sizeof(line), file))
+  {
+    unsigned long kiloBytes;
+    if (sscanf(line, "Hugepagesize: %lu kB", &kiloBytes) == 1)
+    {
+      size = (size_t)kiloBytes * 1024u;
+      break;
+    }
+  }
+  fclose(file);
+
+  atomic_store(&hugePageSize, size);
+  return size;
+}
+
+/* Maps size bytes aligned on alignment, trimming the unaligned ends */
+static void *QuantisMemoryMapAligned(size_t size, size_t alignment)
+{
+  size_t mappedSize = size + alignment;
+  unsigned char *memory;
+  unsigned char *aligned;
+  size_t head;
+  size_t tail;
+
+  /* Mappings are always page aligned */
+  if (alignment <= (size_t)sysconf(_SC_PAGESIZE))
+  {
+    mappedSize = size;
+  }
+
+  memory = (unsigned char *)mmap(NULL, mappedSize, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+  {
+    return NULL;
+  }
+  if (mappedSize == size)
+  {
+    return memory;
+  }
+
+  aligned = (unsigned char *)QuantisMemoryRoundUp((size_t)memory, alignment);
+  head = (size_t)(aligned - memory);
+  tail = mappedSize - head - size;
+  if (head != 0u)
+  {
+    munmap(memory, head);
+  }
+  if (tail != 0u)
+  {
+    munmap(aligned + size, tail);
+  }
+
+  return aligned;
+}
+
+/*
+ * Prefers numaNode for the pages of the buffer. This is done before the
+ * pages are touched, so that they are allocated on the node right away.
+ * Failures are ignored: the buffer is then allocated on the node of the
+ * thread touching it first.
+ */
+static void QuantisMemoryBindToNode(void *buffer, size_t size, int numaNode)
+{
+#ifdef SYS_mbind
+  unsigned long nodeMask[(QUANTIS_MEMORY_MAX_NUMA_NODE + 1) / (8 * sizeof(unsigned long))];
+  const size_t bitsPerLong = 8u * sizeof(unsigned long);
+
+  if ((numaNode < 0) || (numaNode > QUANTIS_MEMORY_MAX_NUMA_NODE))
+  {
+    return;
+  }
+
+  memset(nodeMask, 0, sizeof(nodeMask));
+  nodeMask[(size_t)numaNode / bitsPerLong] = 1ul << ((size_t)numaNode % bitsPerLong);
+
+  /* The kernel expects one more bit than the size of the mask */
+  syscall(SYS_mbind, buffer, size, QUANTIS_MPOL_PREFERRED,
+          nodeMask, (unsigned long)(8u * sizeof(nodeMask) + 1u), 0u);
+#else
+  (void)buffer;
+  (void)size;
+  (void)numaNode;
+#endif
+}
+
+/* Reads a single integer from a sysfs file, returns -1 on failure */
+static int QuantisMemoryReadSysfsInt(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  int value = -1;
+
+  if (!file)
+  {
+    return -1;
+  }
+  if (fscanf(file, "%d", &value) != 1)
+  {
+    value = -1;
+  }
+  fclose(file);
+
+  return value;
+}
+
+#endif /* __linux__ */
+
+int QuantisBufferAlloc(QuantisBuffer *buffer, size_t size, int numaNode)
+{
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+  if (!buffer || (size == 0u))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  buffer->data = NULL;
+  buffer->size = 0u;
+
+#ifdef __linux__
+  {
+    QuantisMemoryMode mode = (QuantisMemoryMode)atomic_load(&QuantisMemoryModeValue);
+    size_t hugePageSize = QuantisMemoryHugePageSize();
+    void *memory = MAP_FAILED;
+    size_t mappedSize;
+
+    /* Reserved hugepages, falls back to transparent hugepages when none is free */
+    if ((mode == QUANTIS_MEMORY_HUGEPAGES) && (hugePageSize != 0u))
+    {
+      mappedSize = QuantisMemoryRoundUp(size, hugePageSize);
+      memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (memory != MAP_FAILED)
+      {
+        QuantisMemoryBindToNode(memory, mappedSize, numaNode);
+        buffer->data = (unsigned char *)memory;
+        buffer->size = mappedSize;
+        return QUANTIS_SUCCESS;
+      }
+    }
+
+    if (mode != QUANTIS_MEMORY_DEFAULT)
+    {
+      mappedSize = QuantisMemoryRoundUp(size, QUANTIS_MEMORY_THP_SIZE);
+      memory = QuantisMemoryMapAligned(mappedSize, QUANTIS_MEMORY_THP_SIZE);
+      if (memory)
+      {
+#ifdef MADV_HUGEPAGE
+        madvise(memory, mappedSize, MADV_HUGEPAGE);
+#endif
+      }
+    }
+    else
+    {
+      mappedSize = QuantisMemoryRoundUp(size, pageSize);
+      memory = QuantisMemoryMapAligned(mappedSize, pageSize);
+    }
+
+    if (!memory)
+    {
+      return QUANTIS_ERROR_NO_MEMORY;
+    }
+
+    QuantisMemoryBindToNode(memory, mappedSize, numaNode);
+    buffer->data = (unsigned char *)memory;
+    buffer->size = mappedSize;
+  }
+#else
+  {
+    void *memory = NULL;
+
+    /* No hugepages nor NUMA placement: page aligned memory */
+    (void)numaNode;
+    if (posix_memalign(&memory, pageSize, size) != 0)
+    {
+      return QUANTIS_ERROR_NO_MEMORY;
+    }
+    buffer->data = (unsigned char *)memory;
+    buffer->size = size;
+  }
+#endif /* __linux__ */
+
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisBufferFree(QuantisBuffer *buffer)
+{
+  if (!buffer || !buffer->data)
+  {
+    return;
+  }
+
+#ifdef __linux__
+  munmap(buffer->data, buffer->size);
+#else
+  free(buffer->data);
+#endif
+
+  buffer->data = NULL;
+  buffer->size = 0u;
+}
+
+int QuantisSetMemoryMode(QuantisMemoryMode mode)
+{
+  if ((mode != QUANTIS_MEMORY_DEFAULT) &&
+      (mode != QUANTIS_MEMORY_HUGEPAGES) &&
+      (mode != QUANTIS_MEMORY_TRANSPARENT_HUGEPAGES))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+#ifndef __linux__
+  if (mode != QUANTIS_MEMORY_DEFAULT)
+  {
+    return QUANTIS_ERROR_OPERATION_NOT_SUPPORTED;
+  }
+#endif
+
+  atomic_store(&QuantisMemoryModeValue, (int)mode);
+
+  return QUANTIS_SUCCESS;
+}
+
+QuantisMemoryMode QuantisGetMemoryMode()
+{
+  return (QuantisMemoryMode)atomic_load(&QuantisMemoryModeValue);
+}
+
+int QuantisGetNumaNodesCount()
+{
+#ifdef __linux__
+  DIR *directory = opendir("/sys/devices/system/node");
+  struct dirent *entry;
+  int count = 0;
+
+  if (!directory)
+  {
+    return 1;
+  }
+
+  while ((entry = readdir(directory)) != NULL)
+  {
+    int node;
+    char end;
+    if (sscanf(entry->d_name, "node%d%c", &node, &end) == 1)
+    {
+      count++;
+    }
+  }
+  closedir(directory);
+
+  return (count > 0) ? count : 1;
+#else
+  return 1;
+#endif
+}
+
+int QuantisGetNumaNode(QuantisDeviceHandle *deviceHandle)
+{
+  if (!deviceHandle)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+#ifdef __linux__
+  if (deviceHandle->deviceType == QUANTIS_DEVICE_PCI)
+  {
+    DIR *directory = NULL;
+    struct dirent *entry;
+    int busDeviceId = deviceHandle->ops->GetBusDeviceId(deviceHandle);
+    int numaNode = -1;
+
+    if (busDeviceId < 0)
+    {
+      return -1;
+    }
+
+    /* Bus number in bits 8-15, device (slot) number in bits 0-7 */
+    directory = opendir("/sys/bus/pci/devices");
+    if (!directory)
+    {
+      return -1;
+    }
+
+    /* Entries are named domain:bus:device.function, e.g. 0000:3b:00.0 */
+    while ((entry = readdir(directory)) != NULL)
+    {
+      unsigned int domain;
+      unsigned int bus;
+      unsigned int device;
+      unsigned int function;
+      char path[320];
+
+      if ((sscanf(entry->d_name, "%x:%x:%x.%x", &domain, &bus, &device, &function) != 4) ||
+          (bus != (((unsigned int)busDeviceId >> 8) & 0xFFu)) ||
+          (device != ((unsigned int)busDeviceId & 0xFFu)))
+      {
+        continue;
+      }
+
+      snprintf(path, sizeof(path), "/sys/bus/pci/devices/%s/numa_node", entry->d_name);
+      numaNode = QuantisMemoryReadSysfsInt(path);
+      break;
+    }
+    closedir(directory);
+
+    return numaNode;
+  }
+#endif /* __linux__ */
+
+  /* USB devices and the simulator have no locality worth considering */
+  return -1;
+}
+
+int QuantisGetCurrentNumaNode()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned int cpu;
+  unsigned int node;
+
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+  {
+    return -1;
+  }
+
+  return (int)node;
+#else
+  return -1;
+#endif
+}
+
+int QuantisBindThreadToNumaNode(int numaNode)
+{
+#ifdef __linux__
+  cpu_set_t cpus;
+  FILE *file = NULL;
+  char path[96];
+  unsigned int first;
+  unsigned int last;
+  int count = 0;
+
+  if ((numaNode < 0) || (numaNode > QUANTIS_MEMORY_MAX_NUMA_NODE))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* The CPU list looks like 0-15,32-47 */
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numaNode);
+  file = fopen(path, "r");
+  if (!file)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  CPU_ZERO(&cpus);
+  while (fscanf(file, "%u", &first) == 1)
+  {
+    unsigned int cpu;
+    last = first;
+    if (fscanf(file, "-%u", &last) != 1)
+    {
+      last = first;
+    }
+    for (cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); cpu++)
+    {
+      CPU_SET(cpu, &cpus);
+      count++;
+    }
+    if (fgetc(file) != ',')
+    {
+      break;
+    }
+  }
+  fclose(file);
+
+  /* Nodes without CPU (memory only) are left alone */
+  if (count == 0)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+  {
+    return QUANTIS_ERROR_OTHER;
+  }
+
+  return QUANTIS_SUCCESS;
+#else
+  (void)numaNode;
+  return QUANTIS_ERROR_OPERATION_NOT_SUPPORTED;
+#endif /* __linux__ */
+}
@@ -87,6 +87,7 @@ typedef struct QuantisPrivateData
 {
   int fd; /* File descriptor */
   char serialNumber[QUANTIS_IOCTL_GET_SERIAL_MAX_LENGTH];
+  QuantisUring *uring; /* Read engine set by QuantisPciSetReadPipeline */
 } QuantisPrivateData;
 
 typedef struct LinuxDirectory
@@ -176,6 +177,7 @@ void QuantisPciClose(QuantisDeviceHandle *deviceHandle)
     return;
   }
 
+  QuantisUringDestroy(_privateData->uring);
   close(_privateData->fd);
 
   free(_privateData);
@@ -400,6 +402,55 @@ int QuantisPciClearAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandl
                          NULL);
 }
 
+/* Rescan */
+int QuantisPciRescan()
+{
+  /* Devices are searched in /dev on every count */
+  return QuantisPciCount();
+}
+
+/* SetReadPipeline */
+int QuantisPciSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                              size_t transferSize,
+                              unsigned int transfersCount)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  int result;
+
+  QuantisUringDestroy(_privateData->uring);
+  _privateData->uring = NULL;
+
+  /*
+   * Reads are queued with io_uring. When io_uring is not available, the
+   * device keeps being read with blocking read() calls.
+   */
+  result = QuantisUringCreateInternal(&deviceHandle,
+                                      &_privateData->fd,
+                                      1u,
+                                      transferSize,
+                                      transfersCount,
+                                      &_privateData->uring);
+  if (result == QUANTIS_ERROR_OPERATION_NOT_SUPPORTED)
+  {
+    return QUANTIS_SUCCESS;
+  }
+
+  return result;
+}
+
+/* GetFd */
+int QuantisPciGetFd(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+
+  if (!_privateData)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  return _privateData->fd;
+}
+
 /* Open */
 int QuantisPciOpen(QuantisDeviceHandle *deviceHandle)
 {
@@ -428,6 +479,7 @@ int QuantisPciOpen(QuantisDeviceHandle *deviceHandle)
   _privateData->fd = fd;
   /* The real serial number will be loaded in QuantisPciGetSerialNumber */
   _privateData->serialNumber[0] = '\0';
+  _privateData->uring = NULL;
 
   deviceHandle->privateData = _privateData;
 
@@ -462,10 +514,20 @@ int QuantisPciOpen(QuantisDeviceHandle *deviceHandle)
 /* Read */
 int QuantisPciRead(QuantisDeviceHandle *deviceHandle, void *buffer, size_t size)
 {
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  int result;
+
+  /* The read engine checks the status before each read it queues */
+  if (_privateData->uring)
+  {
+    return QuantisUringRead(_privateData->uring, buffer, size);
+  }
+
   /* Check if status is ok */
-  if (QuantisPciGetModulesStatus(deviceHandle) <= 0)
+  result = QuantisCheckStatusInternal(deviceHandle, size);
+  if (result < 0)
   {
-    return QUANTIS_ERROR_INVALID_STATUS;
+    return result;
   }
 
   /*
@@ -474,8 +536,6 @@ int QuantisPciRead(QuantisDeviceHandle *deviceHandle, void *buffer, size_t size)
    * several reads are necessary.
    */
   size_t readBytes = 0u;
-  int result = QUANTIS_ERROR_IO;
-  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
   while (readBytes < size)
   {
     result = read(_privateData->fd,
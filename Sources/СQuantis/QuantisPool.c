@@ -0,0 +1,534 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Quantis.h"
+#include "Quantis_Internal.h"
+
+/* Default size (in bytes) of a pool segment */
+#define QUANTIS_POOL_SEGMENT_SIZE (64 * 1024)
+
+/* Default number of segments of a pool */
+#define QUANTIS_POOL_SEGMENTS_COUNT 16
+
+/* Maximal number of segments of a pool */
+#define QUANTIS_POOL_MAX_SEGMENTS_COUNT 1024
+
+/*
+ * The reservation word of a segment packs the epoch of the data held by the
+ * segment (high bits) and the offset of the first byte not reserved yet (low
+ * bits), so that a single fetch-add both reserves bytes and tells which fill
+ * of the segment they belong to. The offset part has enough room for all the
+ * concurrent reservations overshooting the end of a segment.
+ */
+#define QUANTIS_POOL_OFFSET_BITS 40
+#define QUANTIS_POOL_OFFSET_MASK ((UINT64_C(1) << QUANTIS_POOL_OFFSET_BITS) - 1)
+#define QUANTIS_POOL_EPOCH_MASK ((UINT64_C(1) << (64 - QUANTIS_POOL_OFFSET_BITS)) - 1)
+
+#define QUANTIS_POOL_STATE(epoch, offset) \
+  ((((uint64_t)(epoch) & QUANTIS_POOL_EPOCH_MASK) << QUANTIS_POOL_OFFSET_BITS) | (uint64_t)(offset))
+#define QUANTIS_POOL_STATE_EPOCH(state) ((state) >> QUANTIS_POOL_OFFSET_BITS)
+#define QUANTIS_POOL_STATE_OFFSET(state) ((state) & QUANTIS_POOL_OFFSET_MASK)
+
+/* Cache line size, used to keep hot counters of segments apart */
+#define QUANTIS_POOL_CACHE_LINE 64
+
+/**
+ * A segment of the pool. Segment i holds the data of epochs i, i + N,
+ * i + 2N... (N being the number of segments). A segment may only be filled
+ * again once all its bytes have been both reserved and copied out.
+ */
+typedef struct QuantisPoolSegment
+{
+  /* Epoch and reservation cursor (see QUANTIS_POOL_STATE) */
+  _Alignas(QUANTIS_POOL_CACHE_LINE) atomic_uint_fast64_t state;
+
+  /* Number of bytes of the current epoch copied out by consumers */
+  _Alignas(QUANTIS_POOL_CACHE_LINE) atomic_size_t consumed;
+
+  unsigned char *data;
+} QuantisPoolSegment;
+
+/* A thread filling the segments of the pool from one device */
+typedef struct QuantisPoolFiller
+{
+  QuantisPool *pool;
+  QuantisDeviceHandle *deviceHandle;
+  pthread_t thread;
+  int started;
+} QuantisPoolFiller;
+
+struct QuantisPool
+{
+  QuantisPoolSegment *segments;
+  unsigned int segmentsCount;
+  size_t segmentSize;
+
+  /* Data of all the segments, allocated on numaNode */
+  QuantisBuffer memory;
+  int numaNode;
+
+  QuantisPoolFiller *fillers;
+  unsigned int fillersCount;
+
+  /* Epoch consumers are currently reserving bytes from */
+  _Alignas(QUANTIS_POOL_CACHE_LINE) atomic_uint_fast64_t current;
+
+  /* Next epoch to be filled */
+  _Alignas(QUANTIS_POOL_CACHE_LINE) atomic_uint_fast64_t nextFill;
+
+  /* Error of the last failed read of a device, kept until seen by a consumer */
+  atomic_int error;
+
+  atomic_int running;
+
+  /* Slow path: threads only sleep when the pool is empty or full */
+  atomic_int consumersWaiting;
+  atomic_int fillersWaiting;
+  pthread_mutex_t lock;
+  pthread_cond_t consumersCond;
+  pthread_cond_t fillersCond;
+};
+
+/* Wakes up all the threads sleeping on cond if waiting is not 0 */
+static void QuantisPoolWakeUp(QuantisPool *pool,
+                              atomic_int *waiting,
+                              pthread_cond_t *cond)
+{
+  if (atomic_load(waiting) > 0)
+  {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(cond);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/* Returns the segment holding the data of epoch */
+static QuantisPoolSegment *QuantisPoolGetSegment(QuantisPool *pool, uint64_t epoch)
+{
+  return &pool->segments[epoch % pool->segmentsCount];
+}
+
+/*
+ * Returns 1 when the segment of epoch can be filled, that is when it holds
+ * epoch - N and all of its bytes have been copied out.
+ */
+static int QuantisPoolCanFill(QuantisPool *pool, uint64_t epoch)
+{
+  QuantisPoolSegment *segment = QuantisPoolGetSegment(pool, epoch);
+  uint64_t state = atomic_load(&segment->state);
+  return (atomic_load(&pool->error) == 0) &&
+         (QUANTIS_POOL_STATE_EPOCH(state) == ((epoch - pool->segmentsCount) & QUANTIS_POOL_EPOCH_MASK)) &&
+         (atomic_load(&segment->consumed) == pool->segmentSize);
+}
+
+/*
+ * Returns 1 when the segment of epoch holds epoch or a later epoch, 0 when it
+ * still holds an earlier one (epochs are compared modulo the epoch range).
+ */
+static int QuantisPoolIsPublished(QuantisPool *pool, uint64_t epoch)
+{
+  QuantisPoolSegment *segment = QuantisPoolGetSegment(pool, epoch);
+  uint64_t state = atomic_load(&segment->state);
+  uint64_t distance = (QUANTIS_POOL_STATE_EPOCH(state) - epoch) & QUANTIS_POOL_EPOCH_MASK;
+  return distance <= (QUANTIS_POOL_EPOCH_MASK >> 1);
+}
+
+/* Returns 1 when a consumer waiting for epoch should wake up */
+static int QuantisPoolCanConsume(QuantisPool *pool, uint64_t epoch)
+{
+  return !atomic_load(&pool->running) ||
+         (atomic_load(&pool->error) != 0) ||
+         (atomic_load(&pool->current) != epoch) ||
+         QuantisPoolIsPublished(pool, epoch);
+}
+
+static void *QuantisPoolFillerThread(void *arg)
+{
+  QuantisPoolFiller *filler = (QuantisPoolFiller *)arg;
+  QuantisPool *pool = filler->pool;
+
+  /* Writes the segments from the node they are allocated on */
+  if (pool->numaNode >= 0)
+  {
+    QuantisBindThreadToNumaNode(pool->numaNode);
+  }
+
+  while (atomic_load(&pool->running))
+  {
+    /* Claims the next epoch, each epoch is filled by a single thread */
+    uint64_t epoch = atomic_fetch_add(&pool->nextFill, 1u);
+    QuantisPoolSegment *segment = QuantisPoolGetSegment(pool, epoch);
+    size_t filledBytes = 0u;
+
+    while (atomic_load(&pool->running) && (filledBytes < pool->segmentSize))
+    {
+      int result;
+
+      /* Waits until the previous epoch of the segment is consumed */
+      if (!QuantisPoolCanFill(pool, epoch))
+      {
+        pthread_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->fillersWaiting, 1);
+        while (atomic_load(&pool->running) && !QuantisPoolCanFill(pool, epoch))
+        {
+          pthread_cond_wait(&pool->fillersCond, &pool->lock);
+        }
+        atomic_fetch_sub(&pool->fillersWaiting, 1);
+        pthread_mutex_unlock(&pool->lock);
+        continue;
+      }
+
+      result = QuantisReadHandled(filler->deviceHandle,
+                                  segment->data + filledBytes,
+                                  pool->segmentSize - filledBytes);
+      if (result < 0)
+      {
+        /* Retries once the error has been reported to a consumer */
+        atomic_store(&pool->error, result);
+        QuantisPoolWakeUp(pool, &pool->consumersWaiting, &pool->consumersCond);
+        continue;
+      }
+
+      filledBytes += (size_t)result;
+    }
+
+    if (filledBytes < pool->segmentSize)
+    {
+      break;
+    }
+
+    /* Publishes the segment: resets the reservation cursor to the new epoch */
+    atomic_store(&segment->consumed, 0u);
+    atomic_store(&segment->state, QUANTIS_POOL_STATE(epoch, 0u));
+
+    QuantisPoolWakeUp(pool, &pool->consumersWaiting, &pool->consumersCond);
+  }
+
+  return NULL;
+}
+
+int QuantisPoolRead(QuantisPool *pool, void *buffer, size_t size)
+{
+  unsigned char *output = (unsigned char *)buffer;
+  size_t readBytes = 0u;
+
+  if (pool == NULL)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (size > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  while (readBytes < size)
+  {
+    uint64_t epoch = atomic_load(&pool->current);
+    QuantisPoolSegment *segment = QuantisPoolGetSegment(pool, epoch);
+    uint64_t state = atomic_load(&segment->state);
+    size_t chunkSize;
+    size_t offset;
+    int error;
+
+    if (QUANTIS_POOL_STATE_EPOCH(state) != (epoch & QUANTIS_POOL_EPOCH_MASK))
+    {
+      /* The segment is ahead: epoch has been consumed already */
+      if (QuantisPoolIsPublished(pool, epoch))
+      {
+        atomic_compare_exchange_strong(&pool->current, &epoch, epoch + 1u);
+        continue;
+      }
+
+      /* The segment is behind: epoch is not filled yet */
+      error = atomic_exchange(&pool->error, 0);
+      if (error != 0)
+      {
+        QuantisPoolWakeUp(pool, &pool->fillersWaiting, &pool->fillersCond);
+        return error;
+      }
+
+      pthread_mutex_lock(&pool->lock);
+      atomic_fetch_add(&pool->consumersWaiting, 1);
+      while (!QuantisPoolCanConsume(pool, epoch))
+      {
+        pthread_cond_wait(&pool->consumersCond, &pool->lock);
+      }
+      atomic_fetch_sub(&pool->consumersWaiting, 1);
+      pthread_mutex_unlock(&pool->lock);
+
+      if (!atomic_load(&pool->running))
+      {
+        return QUANTIS_ERROR_IO;
+      }
+      continue;
+    }
+
+    if (QUANTIS_POOL_STATE_OFFSET(state) >= pool->segmentSize)
+    {
+      /* The segment is fully reserved: moves consumers to the next epoch */
+      atomic_compare_exchange_strong(&pool->current, &epoch, epoch + 1u);
+      continue;
+    }
+
+    /* Reserves bytes, the reservation tells which epoch they belong to */
+    chunkSize = size - readBytes;
+    if (chunkSize > pool->segmentSize)
+    {
+      chunkSize = pool->segmentSize;
+    }
+    state = atomic_fetch_add(&segment->state, (uint64_t)chunkSize);
+    offset = (size_t)QUANTIS_POOL_STATE_OFFSET(state);
+    if (offset >= pool->segmentSize)
+    {
+      continue;
+    }
+    if (chunkSize > pool->segmentSize - offset)
+    {
+      chunkSize = pool->segmentSize - offset;
+    }
+
+    /*
+     * The reserved bytes are owned by this thread only: the segment cannot be
+     * filled again until they are accounted in consumed.
+     */
+    memcpy(output + readBytes, segment->data + offset, chunkSize);
+    readBytes += chunkSize;
+
+    if (atomic_fetch_add(&segment->consumed, chunkSize) + chunkSize == pool->segmentSize)
+    {
+      QuantisPoolWakeUp(pool, &pool->fillersWaiting, &pool->fillersCond);
+    }
+  }
+
+  return (int)readBytes;
+}
+
+static void QuantisPoolStop(QuantisPool *pool)
+{
+  unsigned int i;
+
+  pthread_mutex_lock(&pool->lock);
+  atomic_store(&pool->running, 0);
+  pthread_cond_broadcast(&pool->fillersCond);
+  pthread_cond_broadcast(&pool->consumersCond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i = 0u; i < pool->fillersCount; i++)
+  {
+    if (pool->fillers[i].started)
+    {
+      pthread_join(pool->fillers[i].thread, NULL);
+      pool->fillers[i].started = 0;
+    }
+  }
+}
+
+void QuantisPoolDestroy(QuantisPool *pool)
+{
+  if (!pool)
+  {
+    return;
+  }
+
+  QuantisPoolStop(pool);
+
+  free(pool->segments);
+  QuantisBufferFree(&pool->memory);
+
+  free(pool->fillers);
+
+  pthread_cond_destroy(&pool->fillersCond);
+  pthread_cond_destroy(&pool->consumersCond);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
+
+int QuantisPoolCreate(QuantisDeviceHandle **deviceHandles,
+                      unsigned int deviceHandlesCount,
+                      size_t segmentSize,
+                      unsigned int segmentsCount,
+                      QuantisPool **pool)
+{
+  return QuantisPoolCreateOnNode(deviceHandles,
+                                 deviceHandlesCount,
+                                 segmentSize,
+                                 segmentsCount,
+                                 -1,
+                                 pool);
+}
+
+int QuantisPoolCreateOnNode(QuantisDeviceHandle **deviceHandles,
+                            unsigned int deviceHandlesCount,
+                            size_t segmentSize,
+                            unsigned int segmentsCount,
+                            int numaNode,
+                            QuantisPool **pool)
+{
+  QuantisPool *_pool = NULL;
+  void *memory = NULL;
+  unsigned int i;
+
+  if (!pool || !deviceHandles || (deviceHandlesCount == 0u))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *pool = NULL;
+
+  for (i = 0u; i < deviceHandlesCount; i++)
+  {
+    if (!deviceHandles[i])
+    {
+      return QUANTIS_ERROR_IO;
+    }
+  }
+
+  if (segmentSize == 0u)
+  {
+    segmentSize = QUANTIS_POOL_SEGMENT_SIZE;
+  }
+  if (segmentsCount == 0u)
+  {
+    segmentsCount = QUANTIS_POOL_SEGMENTS_COUNT;
+  }
+  if ((segmentSize > QUANTIS_MAX_READ_SIZE) ||
+      (segmentsCount < 2u) ||
+      (segmentsCount > QUANTIS_POOL_MAX_SEGMENTS_COUNT) ||
+      (numaNode < -1))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  if (posix_memalign(&memory, QUANTIS_POOL_CACHE_LINE, sizeof(QuantisPool)) != 0)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+  _pool = (QuantisPool *)memory;
+  memset(_pool, 0, sizeof(QuantisPool));
+
+  _pool->segmentsCount = segmentsCount;
+  _pool->segmentSize = segmentSize;
+  _pool->fillersCount = deviceHandlesCount;
+  _pool->numaNode = numaNode;
+  atomic_init(&_pool->current, 0u);
+  atomic_init(&_pool->nextFill, 0u);
+  atomic_init(&_pool->error, 0);
+  atomic_init(&_pool->running, 1);
+  atomic_init(&_pool->consumersWaiting, 0);
+  atomic_init(&_pool->fillersWaiting, 0);
+  pthread_mutex_init(&_pool->lock, NULL);
+  pthread_cond_init(&_pool->consumersCond, NULL);
+  pthread_cond_init(&_pool->fillersCond, NULL);
+
+  /* Places the pool on the node of the first device with a known node */
+  for (i = 0u; (i < deviceHandlesCount) && (_pool->numaNode < 0); i++)
+  {
+    _pool->numaNode = QuantisGetNumaNode(deviceHandles[i]);
+  }
+
+  /* Allocates segments, with their data in a single buffer */
+  if (QuantisBufferAlloc(&_pool->memory, (size_t)segmentsCount * segmentSize, _pool->numaNode) != QUANTIS_SUCCESS)
+  {
+    goto cleanup;
+  }
+
+  memory = NULL;
+  if (posix_memalign(&memory, QUANTIS_POOL_CACHE_LINE, segmentsCount * sizeof(QuantisPoolSegment)) != 0)
+  {
+    goto cleanup;
+  }
+  _pool->segments = (QuantisPoolSegment *)memory;
+  memset(_pool->segments, 0, segmentsCount * sizeof(QuantisPoolSegment));
+
+  for (i = 0u; i < segmentsCount; i++)
+  {
+    QuantisPoolSegment *segment = &_pool->segments[i];
+
+    /* Segment i starts as the fully consumed epoch i - N */
+    atomic_init(&segment->state, QUANTIS_POOL_STATE((uint64_t)i - segmentsCount, segmentSize));
+    atomic_init(&segment->consumed, segmentSize);
+
+    segment->data = _pool->memory.data + (size_t)i * segmentSize;
+  }
+
+  /* Starts a filler per device */
+  _pool->fillers = (QuantisPoolFiller *)calloc(deviceHandlesCount, sizeof(QuantisPoolFiller));
+  if (!_pool->fillers)
+  {
+    goto cleanup;
+  }
+
+  for (i = 0u; i < deviceHandlesCount; i++)
+  {
+    QuantisPoolFiller *filler = &_pool->fillers[i];
+    filler->pool = _pool;
+    filler->deviceHandle = deviceHandles[i];
+    if (pthread_create(&filler->thread, NULL, QuantisPoolFillerThread, filler) != 0)
+    {
+      QuantisPoolDestroy(_pool);
+      return QUANTIS_ERROR_OTHER;
+    }
+    filler->started = 1;
+  }
+
+  *pool = _pool;
+
+  return QUANTIS_SUCCESS;
+
+cleanup:
+  QuantisPoolDestroy(_pool);
+  return QUANTIS_ERROR_NO_MEMORY;
+}
@@ -0,0 +1,358 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Quantis.h"
+#include "Quantis_Internal.h"
+
+/* Size (in bytes) of the chunks read from the device by the prefetch thread */
+#define QUANTIS_PREFETCH_CHUNK_SIZE (64 * 1024)
+
+/* Minimal size (in bytes) of a prefetch buffer */
+#define QUANTIS_PREFETCH_MIN_SIZE (4 * 1024)
+
+/**
+ * Prefetch buffer of a handle.
+ *
+ * This is a single-producer/single-consumer ring: the prefetch thread is the
+ * only one writing head and the thread reading the handle is the only one
+ * writing tail. Both only grow, the position in the ring is obtained by
+ * masking them with (capacity - 1).
+ *
+ * The prefetch thread fills the ring until it is full (high watermark) and
+ * then sleeps until the consumer has emptied it down to lowWatermark, so the
+ * device is always read by large chunks. Threads only sleep on lock when the
+ * ring is full or empty.
+ */
+struct QuantisPrefetcher
+{
+  QuantisDeviceHandle *deviceHandle;
+  unsigned char *buffer;
+  QuantisBuffer memory;
+  size_t capacity;
+  size_t chunkSize;
+  size_t lowWatermark;
+
+  /* Node of the device, the thread and the buffer are kept on it */
+  int numaNode;
+
+  atomic_size_t head;
+  atomic_size_t tail;
+
+  /* Error of the last read of the device, kept until seen by the consumer */
+  atomic_int error;
+
+  atomic_int running;
+  atomic_int producerWaiting;
+  atomic_int consumerWaiting;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t producerCond;
+  pthread_cond_t consumerCond;
+};
+
+/* Wakes up a thread sleeping on cond if waiting is set */
+static void QuantisPrefetchWakeUp(QuantisPrefetcher *prefetcher,
+                                  atomic_int *waiting,
+                                  pthread_cond_t *cond)
+{
+  if (atomic_load(waiting))
+  {
+    pthread_mutex_lock(&prefetcher->lock);
+    pthread_cond_signal(cond);
+    pthread_mutex_unlock(&prefetcher->lock);
+  }
+}
+
+/* Returns 1 when the prefetch thread can read the device again */
+static int QuantisPrefetchCanFill(QuantisPrefetcher *prefetcher)
+{
+  return (atomic_load(&prefetcher->error) == 0) &&
+         ((atomic_load(&prefetcher->head) - atomic_load(&prefetcher->tail)) <= prefetcher->lowWatermark);
+}
+
+static void *QuantisPrefetchThread(void *arg)
+{
+  QuantisPrefetcher *prefetcher = (QuantisPrefetcher *)arg;
+  QuantisDeviceHandle *deviceHandle = prefetcher->deviceHandle;
+
+  if (prefetcher->numaNode >= 0)
+  {
+    QuantisBindThreadToNumaNode(prefetcher->numaNode);
+  }
+
+  while (atomic_load(&prefetcher->running))
+  {
+    size_t head = atomic_load_explicit(&prefetcher->head, memory_order_relaxed);
+    size_t fill = head - atomic_load(&prefetcher->tail);
+    size_t offset = head & (prefetcher->capacity - 1);
+    size_t size;
+    int result;
+
+    /* Sleeps when the ring is full or until the consumer has seen an error */
+    if ((fill == prefetcher->capacity) || (atomic_load(&prefetcher->error) != 0))
+    {
+      pthread_mutex_lock(&prefetcher->lock);
+      atomic_store(&prefetcher->producerWaiting, 1);
+      while (atomic_load(&prefetcher->running) && !QuantisPrefetchCanFill(prefetcher))
+      {
+        pthread_cond_wait(&prefetcher->producerCond, &prefetcher->lock);
+      }
+      atomic_store(&prefetcher->producerWaiting, 0);
+      pthread_mutex_unlock(&prefetcher->lock);
+      continue;
+    }
+
+    /* Reads a chunk of contiguous free space */
+    size = prefetcher->capacity - fill;
+    if (size > prefetcher->capacity - offset)
+    {
+      size = prefetcher->capacity - offset;
+    }
+    if (size > prefetcher->chunkSize)
+    {
+      size = prefetcher->chunkSize;
+    }
+
+    result = deviceHandle->ops->Read(deviceHandle, prefetcher->buffer + offset, size);
+    if (result < 0)
+    {
+      atomic_store(&prefetcher->error, result);
+    }
+    else
+    {
+      atomic_store(&prefetcher->head, head + (size_t)result);
+    }
+
+    QuantisPrefetchWakeUp(prefetcher, &prefetcher->consumerWaiting, &prefetcher->consumerCond);
+  }
+
+  return NULL;
+}
+
+int QuantisPrefetchRead(QuantisDeviceHandle *deviceHandle, void *buffer, size_t size)
+{
+  QuantisPrefetcher *prefetcher = deviceHandle->prefetcher;
+  size_t readBytes = 0u;
+
+  while (readBytes < size)
+  {
+    size_t tail = atomic_load_explicit(&prefetcher->tail, memory_order_relaxed);
+    size_t available = atomic_load(&prefetcher->head) - tail;
+    size_t offset = tail & (prefetcher->capacity - 1);
+    size_t chunkSize;
+    size_t firstPart;
+
+    if (available == 0u)
+    {
+      int error = atomic_load(&prefetcher->error);
+      if (error != 0)
+      {
+        /* Lets the prefetch thread try again */
+        atomic_store(&prefetcher->error, 0);
+        QuantisPrefetchWakeUp(prefetcher, &prefetcher->producerWaiting, &prefetcher->producerCond);
+        return error;
+      }
+
+      /* The ring is empty: waits for the prefetch thread */
+      pthread_mutex_lock(&prefetcher->lock);
+      atomic_store(&prefetcher->consumerWaiting, 1);
+      while (atomic_load(&prefetcher->running) &&
+             (atomic_load(&prefetcher->head) == tail) &&
+             (atomic_load(&prefetcher->error) == 0))
+      {
+        pthread_cond_wait(&prefetcher->consumerCond, &prefetcher->lock);
+      }
+      atomic_store(&prefetcher->consumerWaiting, 0);
+      pthread_mutex_unlock(&prefetcher->lock);
+
+      if (!atomic_load(&prefetcher->running))
+      {
+        return QUANTIS_ERROR_IO;
+      }
+      continue;
+    }
+
+    chunkSize = size - readBytes;
+    if (chunkSize > available)
+    {
+      chunkSize = available;
+    }
+
+    /* Copies data to user's buffer, the chunk may wrap around the ring */
+    firstPart = prefetcher->capacity - offset;
+    if (firstPart > chunkSize)
+    {
+      firstPart = chunkSize;
+    }
+    memcpy((unsigned char *)buffer + readBytes, prefetcher->buffer + offset, firstPart);
+    memcpy((unsigned char *)buffer + readBytes + firstPart, prefetcher->buffer, chunkSize - firstPart);
+
+    atomic_store(&prefetcher->tail, tail + chunkSize);
+    readBytes += chunkSize;
+
+    if (QuantisPrefetchCanFill(prefetcher))
+    {
+      QuantisPrefetchWakeUp(prefetcher, &prefetcher->producerWaiting, &prefetcher->producerCond);
+    }
+  }
+
+  return (int)readBytes;
+}
+
+size_t QuantisPrefetchGetSize(QuantisDeviceHandle *deviceHandle)
+{
+  if (!deviceHandle || !deviceHandle->prefetcher)
+  {
+    return 0u;
+  }
+
+  return deviceHandle->prefetcher->capacity;
+}
+
+int QuantisStartPrefetch(QuantisDeviceHandle *deviceHandle, size_t bufferSize)
+{
+  QuantisPrefetcher *prefetcher = NULL;
+  size_t capacity = QUANTIS_PREFETCH_MIN_SIZE;
+
+  if (deviceHandle == NULL)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if ((bufferSize == 0u) || (bufferSize > QUANTIS_MAX_READ_SIZE))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  QuantisStopPrefetch(deviceHandle);
+
+  /* The ring capacity is a power of two */
+  while (capacity < bufferSize)
+  {
+    capacity *= 2u;
+  }
+
+  prefetcher = (QuantisPrefetcher *)malloc(sizeof(QuantisPrefetcher));
+  if (!prefetcher)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  prefetcher->numaNode = QuantisGetNumaNode(deviceHandle);
+  if (QuantisBufferAlloc(&prefetcher->memory, capacity, prefetcher->numaNode) != QUANTIS_SUCCESS)
+  {
+    free(prefetcher);
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+  prefetcher->buffer = prefetcher->memory.data;
+
+  prefetcher->deviceHandle = deviceHandle;
+  prefetcher->capacity = capacity;
+  prefetcher->chunkSize = (capacity / 2u < QUANTIS_PREFETCH_CHUNK_SIZE) ? capacity / 2u : QUANTIS_PREFETCH_CHUNK_SIZE;
+  prefetcher->lowWatermark = capacity / 2u;
+  atomic_init(&prefetcher->head, 0u);
+  atomic_init(&prefetcher->tail, 0u);
+  atomic_init(&prefetcher->error, 0);
+  atomic_init(&prefetcher->running, 1);
+  atomic_init(&prefetcher->producerWaiting, 0);
+  atomic_init(&prefetcher->consumerWaiting, 0);
+  pthread_mutex_init(&prefetcher->lock, NULL);
+  pthread_cond_init(&prefetcher->producerCond, NULL);
+  pthread_cond_init(&prefetcher->consumerCond, NULL);
+
+  if (pthread_create(&prefetcher->thread, NULL, QuantisPrefetchThread, prefetcher) != 0)
+  {
+    pthread_cond_destroy(&prefetcher->consumerCond);
+    pthread_cond_destroy(&prefetcher->producerCond);
+    pthread_mutex_destroy(&prefetcher->lock);
+    QuantisBufferFree(&prefetcher->memory);
+    free(prefetcher);
+    return QUANTIS_ERROR_OTHER;
+  }
+
+  deviceHandle->prefetcher = prefetcher;
+
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisStopPrefetch(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrefetcher *prefetcher = NULL;
+
+  if (!deviceHandle || !deviceHandle->prefetcher)
+  {
+    return;
+  }
+
+  prefetcher = deviceHandle->prefetcher;
+
+  pthread_mutex_lock(&prefetcher->lock);
+  atomic_store(&prefetcher->running, 0);
+  pthread_cond_broadcast(&prefetcher->producerCond);
+  pthread_cond_broadcast(&prefetcher->consumerCond);
+  pthread_mutex_unlock(&prefetcher->lock);
+
+  /* The thread ends once its current read of the device is done */
+  pthread_join(prefetcher->thread, NULL);
+
+  pthread_cond_destroy(&prefetcher->consumerCond);
+  pthread_cond_destroy(&prefetcher->producerCond);
+  pthread_mutex_destroy(&prefetcher->lock);
+  QuantisBufferFree(&prefetcher->memory);
+  free(prefetcher);
+
+  deviceHandle->prefetcher = NULL;
+}
@@ -0,0 +1,263 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Quantis.h"
+
+/* Groups of values are drawn below range^k <= 2^62, so that 2 * range^k fits */
+#define QUANTIS_SAMPLER_MAX_GROUP_RANGE (UINT64_C(1) << 62)
+
+struct QuantisSampler
+{
+  QuantisDeviceHandle *deviceHandle;
+  QuantisBitPool *bitPool;
+
+  /* Range of the current group, and values of the group not returned yet */
+  uint64_t range;
+  uint64_t groupRange;
+  unsigned int groupLength;
+  double groupEntropy;
+  uint64_t group;
+  unsigned int groupLeft;
+
+  QuantisSamplerStats stats;
+};
+
+/*
+ * Draws a uniform value below range (2 to 2^62) with the Fast Dice Roller
+ * (J. Lumbroso, 2013). v is the number of equally likely values of c: it is
+ * doubled with each new bit until it covers range, and the values of c
+ * beyond range are kept as a smaller uniform state instead of being lost.
+ */
+static int QuantisSamplerDrawBelow(QuantisSampler *sampler, uint64_t range, uint64_t *value)
+{
+  uint64_t v = 1u;
+  uint64_t c = 0u;
+
+  for (;;)
+  {
+    unsigned int count = 0u;
+    unsigned long long bits;
+    int result;
+
+    /* Takes at once all the bits the bit-by-bit algorithm would take */
+    while ((v << count) < range)
+    {
+      count++;
+    }
+
+    result = QuantisBitPoolTakeBits(sampler->bitPool, count, &bits);
+    if (result < 0)
+    {
+      return result;
+    }
+    sampler->stats.bitsConsumed += count;
+
+    v <<= count;
+    c = (c << count) | bits;
+    if (c < range)
+    {
+      *value = c;
+      return QUANTIS_SUCCESS;
+    }
+    v -= range;
+    c -= range;
+  }
+}
+
+/* Selects the group size for range (2 to 2^32) and drops the current group */
+static void QuantisSamplerSetRange(QuantisSampler *sampler, uint64_t range)
+{
+  sampler->range = range;
+  sampler->groupRange = range;
+  sampler->groupLength = 1u;
+  while (sampler->groupRange <= QUANTIS_SAMPLER_MAX_GROUP_RANGE / range)
+  {
+    sampler->groupRange *= range;
+    sampler->groupLength++;
+  }
+  sampler->groupEntropy = log2((double)range);
+  sampler->groupLeft = 0u;
+}
+
+int QuantisSamplerCreate(QuantisDeviceType deviceType,
+                         unsigned int deviceNumber,
+                         size_t bufferSize,
+                         QuantisSampler **sampler)
+{
+  QuantisSampler *newSampler = NULL;
+  int result;
+
+  if (sampler == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *sampler = NULL;
+
+  newSampler = (QuantisSampler *)calloc(1u, sizeof(QuantisSampler));
+  if (newSampler == NULL)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  result = QuantisOpen(deviceType, deviceNumber, &newSampler->deviceHandle);
+  if (result < 0)
+  {
+    newSampler->deviceHandle = NULL;
+    goto cleanup;
+  }
+
+  result = QuantisBitPoolCreate(newSampler->deviceHandle, bufferSize, &newSampler->bitPool);
+  if (result < 0)
+  {
+    goto cleanup;
+  }
+
+  *sampler = newSampler;
+  return QUANTIS_SUCCESS;
+
+cleanup:
+  QuantisSamplerDestroy(newSampler);
+  return result;
+}
+
+void QuantisSamplerDestroy(QuantisSampler *sampler)
+{
+  if (sampler == NULL)
+  {
+    return;
+  }
+
+  QuantisBitPoolDestroy(sampler->bitPool);
+  if (sampler->deviceHandle != NULL)
+  {
+    QuantisClose(sampler->deviceHandle);
+  }
+  free(sampler);
+}
+
+int QuantisSamplerReadInt(QuantisSampler *sampler,
+                          int *value,
+                          int min,
+                          int max)
+{
+  return QuantisSamplerReadIntArray(sampler, value, 1u, min, max);
+}
+
+int QuantisSamplerReadIntArray(QuantisSampler *sampler,
+                               int *values,
+                               size_t count,
+                               int min,
+                               int max)
+{
+  uint64_t range;
+  size_t i;
+
+  if ((sampler == NULL) || (min > max) || ((values == NULL) && (count > 0u)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  range = (uint64_t)((int64_t)max - (int64_t)min + 1);
+  if (range == 1u)
+  {
+    /* No randomness needed */
+    for (i = 0u; i < count; i++)
+    {
+      values[i] = min;
+    }
+    sampler->stats.valuesCount += count;
+    return QUANTIS_SUCCESS;
+  }
+
+  if (range != sampler->range)
+  {
+    QuantisSamplerSetRange(sampler, range);
+  }
+
+  for (i = 0u; i < count; i++)
+  {
+    if (sampler->groupLeft == 0u)
+    {
+      int result = QuantisSamplerDrawBelow(sampler, sampler->groupRange, &sampler->group);
+      if (result < 0)
+      {
+        return result;
+      }
+      sampler->groupLeft = sampler->groupLength;
+      sampler->stats.bitsProduced += sampler->groupEntropy * sampler->groupLength;
+    }
+
+    /* The group is a number of groupLength digits in base range */
+    values[i] = (int)((int64_t)min + (int64_t)(sampler->group % range));
+    sampler->group /= range;
+    sampler->groupLeft--;
+    sampler->stats.valuesCount++;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisSamplerGetStats(const QuantisSampler *sampler,
+                           QuantisSamplerStats *stats)
+{
+  if ((sampler == NULL) || (stats == NULL))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  *stats = sampler->stats;
+  QuantisBitPoolGetStats(sampler->bitPool, &stats->bitsRead, NULL);
+
+  return QUANTIS_SUCCESS;
+}
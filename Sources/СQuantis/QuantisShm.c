@@ -0,0 +1,781 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Quantis.h"
+
+/* Counters are shared between processes, so they must not rely on locks */
+#if ATOMIC_LLONG_LOCK_FREE != 2 || ATOMIC_INT_LOCK_FREE != 2
+#error "Quantis shared memory rings need lock-free 64-bit atomics"
+#endif
+
+/* Identifies a ring, and the layout of this version of the library */
+#define QUANTIS_SHM_MAGIC 0x51534852u
+#define QUANTIS_SHM_VERSION 2u
+
+/* Default size (in bytes) of a ring segment */
+#define QUANTIS_SHM_SEGMENT_SIZE (64 * 1024)
+
+/* Default number of segments of a ring */
+#define QUANTIS_SHM_SEGMENTS_COUNT 64
+
+/* Maximal number of segments of a ring */
+#define QUANTIS_SHM_MAX_SEGMENTS_COUNT 4096
+
+/* Maximal number of processes having a ring open at the same time */
+#define QUANTIS_SHM_MAX_CONSUMERS 256
+
+/* Reservation word of a segment, see QUANTIS_POOL_STATE in QuantisPool.c */
+#define QUANTIS_SHM_OFFSET_BITS 40
+#define QUANTIS_SHM_OFFSET_MASK ((UINT64_C(1) << QUANTIS_SHM_OFFSET_BITS) - 1)
+#define QUANTIS_SHM_EPOCH_MASK ((UINT64_C(1) << (64 - QUANTIS_SHM_OFFSET_BITS)) - 1)
+
+#define QUANTIS_SHM_STATE(epoch, offset) \
+  ((((uint64_t)(epoch) & QUANTIS_SHM_EPOCH_MASK) << QUANTIS_SHM_OFFSET_BITS) | (uint64_t)(offset))
+#define QUANTIS_SHM_STATE_EPOCH(state) ((state) >> QUANTIS_SHM_OFFSET_BITS)
+#define QUANTIS_SHM_STATE_OFFSET(state) ((state) & QUANTIS_SHM_OFFSET_MASK)
+
+/* Reservation size of a consumer slot about to reserve an unknown size */
+#define QUANTIS_SHM_RESERVATION_PENDING UINT64_MAX
+
+#define QUANTIS_SHM_CACHE_LINE 64
+
+/* Waiting threads spin, then yield, then sleep this long between checks */
+#define QUANTIS_SHM_SPINS 64u
+#define QUANTIS_SHM_YIELDS 64u
+#define QUANTIS_SHM_SLEEP_NS 50000L
+
+/* A stalled producer looks for dead consumers after this many sleeps */
+#define QUANTIS_SHM_RECOVERY_SLEEPS 200u
+
+/**
+ * A segment of the ring, holding epochs i, i + N, i + 2N... as in a
+ * QuantisPool. The bytes of a segment are zeroed by the consumers copying
+ * them out, so that they can never be read twice.
+ *
+ * consumed is tagged with its epoch like state, so that bytes accounted
+ * late (by a consumer or on recovery) can never count for the next epoch.
+ */
+typedef struct QuantisShmSegment
+{
+  _Alignas(QUANTIS_SHM_CACHE_LINE) atomic_uint_fast64_t state;
+  _Alignas(QUANTIS_SHM_CACHE_LINE) atomic_uint_fast64_t consumed;
+} QuantisShmSegment;
+
+/**
+ * A process having the ring open. The reservation being copied is recorded
+ * so that the producer can release it if the process dies meanwhile. It is
+ * marked QUANTIS_SHM_RESERVATION_PENDING before reserving, so that a process
+ * dying before its reservation is recorded still shows on which segment.
+ */
+typedef struct QuantisShmConsumerSlot
+{
+  _Alignas(QUANTIS_SHM_CACHE_LINE) atomic_int pid;
+  atomic_uint_fast64_t reservedEpoch;
+  atomic_uint_fast64_t reservedSize;
+  atomic_uint_fast64_t bytesConsumed;
+} QuantisShmConsumerSlot;
+
+/* Header at the start of the shared memory, followed by the data */
+typedef struct QuantisShmHeader
+{
+  /* Written last by the producer, once the ring is initialized */
+  atomic_uint magic;
+  uint32_t version;
+  uint64_t segmentSize;
+  uint32_t segmentsCount;
+  uint64_t dataOffset;
+  uint64_t mappingSize;
+
+  atomic_int producerPid;
+  atomic_int running;
+
+  /* Error of the last failed read of the device, kept until seen */
+  atomic_int error;
+
+  /* Epoch consumers are currently reserving bytes from */
+  _Alignas(QUANTIS_SHM_CACHE_LINE) atomic_uint_fast64_t current;
+
+  QuantisShmConsumerSlot consumers[QUANTIS_SHM_MAX_CONSUMERS];
+  QuantisShmSegment segments[];
+} QuantisShmHeader;
+
+struct QuantisShmProducer
+{
+  QuantisShmHeader *header;
+  unsigned char *data;
+  char *name;
+  QuantisDeviceHandle *deviceHandle;
+  pthread_t thread;
+  int started;
+};
+
+struct QuantisShmConsumer
+{
+  QuantisShmHeader *header;
+  unsigned char *data;
+  size_t mappingSize;
+  QuantisShmConsumerSlot *slot;
+};
+
+/* Waits a little longer each time it is called with the same counter */
+static void QuantisShmBackoff(unsigned int *waits)
+{
+  if (*waits < QUANTIS_SHM_SPINS)
+  {
+    /* Nothing, the caller checks again right away */
+  }
+  else if (*waits < QUANTIS_SHM_SPINS + QUANTIS_SHM_YIELDS)
+  {
+    sched_yield();
+  }
+  else
+  {
+    struct timespec delay = {0, QUANTIS_SHM_SLEEP_NS};
+    nanosleep(&delay, NULL);
+  }
+  (*waits)++;
+}
+
+static int QuantisShmIsProcessDead(int pid)
+{
+  return (kill((pid_t)pid, 0) < 0) && (errno == ESRCH);
+}
+
+static QuantisShmSegment *QuantisShmGetSegment(QuantisShmHeader *header, uint64_t epoch)
+{
+  return &header->segments[epoch % header->segmentsCount];
+}
+
+/* Accounts size bytes of epoch as consumed, unless the segment moved on */
+static void QuantisShmConsume(QuantisShmHeader *header, uint64_t epoch, uint64_t size)
+{
+  QuantisShmSegment *segment = QuantisShmGetSegment(header, epoch);
+  uint64_t consumed = atomic_load(&segment->consumed);
+
+  while (QUANTIS_SHM_STATE_EPOCH(consumed) == (epoch & QUANTIS_SHM_EPOCH_MASK))
+  {
+    if (atomic_compare_exchange_weak(&segment->consumed, &consumed, consumed + size))
+    {
+      break;
+    }
+  }
+}
+
+/* See QuantisPoolCanFill */
+static int QuantisShmCanFill(QuantisShmHeader *header, uint64_t epoch)
+{
+  QuantisShmSegment *segment = QuantisShmGetSegment(header, epoch);
+  uint64_t previousEpoch = (epoch - header->segmentsCount) & QUANTIS_SHM_EPOCH_MASK;
+  uint64_t state = atomic_load(&segment->state);
+  uint64_t consumed = atomic_load(&segment->consumed);
+  return (atomic_load(&header->error) == 0) &&
+         (QUANTIS_SHM_STATE_EPOCH(state) == previousEpoch) &&
+         (QUANTIS_SHM_STATE_EPOCH(consumed) == previousEpoch) &&
+         (QUANTIS_SHM_STATE_OFFSET(consumed) >= header->segmentSize);
+}
+
+/* See QuantisPoolIsPublished */
+static int QuantisShmIsPublished(QuantisShmHeader *header, uint64_t epoch)
+{
+  QuantisShmSegment *segment = QuantisShmGetSegment(header, epoch);
+  uint64_t state = atomic_load(&segment->state);
+  uint64_t distance = (QUANTIS_SHM_STATE_EPOCH(state) - epoch) & QUANTIS_SHM_EPOCH_MASK;
+  return distance <= (QUANTIS_SHM_EPOCH_MASK >> 1);
+}
+
+/* Releases the slots of dead consumers, and the bytes they had reserved */
+static void QuantisShmRecoverConsumers(QuantisShmHeader *header)
+{
+  unsigned int i;
+
+  for (i = 0u; i < QUANTIS_SHM_MAX_CONSUMERS; i++)
+  {
+    QuantisShmConsumerSlot *slot = &header->consumers[i];
+    int pid = atomic_load(&slot->pid);
+    uint64_t reservedSize;
+
+    if ((pid == 0) || !QuantisShmIsProcessDead(pid))
+    {
+      continue;
+    }
+
+    /* The size of a pending reservation is unknown, see QuantisShmReleaseLost */
+    reservedSize = atomic_exchange(&slot->reservedSize, 0u);
+    if ((reservedSize > 0u) && (reservedSize != QUANTIS_SHM_RESERVATION_PENDING))
+    {
+      QuantisShmConsume(header, atomic_load(&slot->reservedEpoch), reservedSize);
+    }
+    atomic_compare_exchange_strong(&slot->pid, &pid, 0);
+  }
+}
+
+/*
+ * Completes the previous epoch of the segment of epoch when it is fully
+ * reserved but no consumer holds a reservation on it anymore: the missing
+ * bytes were reserved by a process that died before recording how many.
+ * Consumers record a reservation before making it, so none can be missed.
+ */
+static void QuantisShmReleaseLost(QuantisShmHeader *header, uint64_t epoch)
+{
+  QuantisShmSegment *segment = QuantisShmGetSegment(header, epoch);
+  uint64_t previousEpoch = (epoch - header->segmentsCount) & QUANTIS_SHM_EPOCH_MASK;
+  uint64_t state = atomic_load(&segment->state);
+  uint64_t consumed;
+  unsigned int i;
+
+  if ((QUANTIS_SHM_STATE_EPOCH(state) != previousEpoch) ||
+      (QUANTIS_SHM_STATE_OFFSET(state) < header->segmentSize))
+  {
+    return;
+  }
+
+  for (i = 0u; i < QUANTIS_SHM_MAX_CONSUMERS; i++)
+  {
+    QuantisShmConsumerSlot *slot = &header->consumers[i];
+    if ((atomic_load(&slot->reservedSize) != 0u) &&
+        ((atomic_load(&slot->reservedEpoch) % header->segmentsCount) == (epoch % header->segmentsCount)))
+    {
+      return;
+    }
+  }
+
+  consumed = atomic_load(&segment->consumed);
+  if ((QUANTIS_SHM_STATE_EPOCH(consumed) == previousEpoch) &&
+      (QUANTIS_SHM_STATE_OFFSET(consumed) < header->segmentSize))
+  {
+    atomic_compare_exchange_strong(&segment->consumed,
+                                   &consumed,
+                                   QUANTIS_SHM_STATE(previousEpoch, header->segmentSize));
+  }
+}
+
+int QuantisShmIsActive(const char *name)
+{
+  QuantisShmHeader *header;
+  struct stat status;
+  void *mapping;
+  int active;
+  int fd;
+
+  if (!name)
+  {
+    name = QUANTIS_SHM_DEFAULT_NAME;
+  }
+
+  fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+  {
+    return 0;
+  }
+
+  if ((fstat(fd, &status) < 0) || ((size_t)status.st_size < sizeof(QuantisShmHeader)))
+  {
+    close(fd);
+    return 0;
+  }
+
+  mapping = mmap(NULL, sizeof(QuantisShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    return 0;
+  }
+
+  header = (QuantisShmHeader *)mapping;
+  active = (atomic_load(&header->magic) == QUANTIS_SHM_MAGIC) &&
+           (header->version == QUANTIS_SHM_VERSION) &&
+           atomic_load(&header->running) &&
+           !QuantisShmIsProcessDead(atomic_load(&header->producerPid));
+  munmap(mapping, sizeof(QuantisShmHeader));
+
+  return active;
+}
+
+static void *QuantisShmProducerThread(void *arg)
+{
+  QuantisShmProducer *producer = (QuantisShmProducer *)arg;
+  QuantisShmHeader *header = producer->header;
+  uint64_t epoch = header->segmentsCount;
+
+  /* Epochs 0 to N - 1 are published empty, so filling starts at N */
+  while (atomic_load(&header->running))
+  {
+    QuantisShmSegment *segment = QuantisShmGetSegment(header, epoch);
+    unsigned char *data = producer->data + (size_t)(epoch % header->segmentsCount) * header->segmentSize;
+    size_t filledBytes = 0u;
+    unsigned int waits = 0u;
+
+    while (atomic_load(&header->running) && (filledBytes < header->segmentSize))
+    {
+      int result;
+
+      /* Waits until the previous epoch of the segment is consumed */
+      if (!QuantisShmCanFill(header, epoch))
+      {
+        QuantisShmBackoff(&waits);
+        if ((waits % QUANTIS_SHM_RECOVERY_SLEEPS) == 0u)
+        {
+          QuantisShmRecoverConsumers(header);
+          QuantisShmReleaseLost(header, epoch);
+        }
+        continue;
+      }
+
+      result = QuantisReadHandled(producer->deviceHandle,
+                                  data + filledBytes,
+                                  header->segmentSize - filledBytes);
+      if (result < 0)
+      {
+        /* Retries once the error has been reported to a consumer */
+        atomic_store(&header->error, result);
+        QuantisShmBackoff(&waits);
+        continue;
+      }
+
+      filledBytes += (size_t)result;
+    }
+
+    if (filledBytes < header->segmentSize)
+    {
+      break;
+    }
+
+    /* Publishes the segment: resets the reservation cursor to the new epoch */
+    atomic_store(&segment->consumed, QUANTIS_SHM_STATE(epoch, 0u));
+    atomic_store(&segment->state, QUANTIS_SHM_STATE(epoch, 0u));
+    epoch++;
+  }
+
+  return NULL;
+}
+
+int QuantisShmCreate(const char *name,
+                     QuantisDeviceHandle *deviceHandle,
+                     size_t segmentSize,
+                     unsigned int segmentsCount,
+                     QuantisShmProducer **producer)
+{
+  QuantisShmProducer *_producer = NULL;
+  QuantisShmHeader *header;
+  size_t segmentsOffset;
+  size_t dataOffset;
+  size_t mappingSize;
+  void *mapping;
+  unsigned int i;
+  int fd;
+  int result;
+
+  if (!producer)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *producer = NULL;
+
+  if (!deviceHandle)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (!name)
+  {
+    name = QUANTIS_SHM_DEFAULT_NAME;
+  }
+
+  if (segmentSize == 0u)
+  {
+    segmentSize = QUANTIS_SHM_SEGMENT_SIZE;
+  }
+  if (segmentsCount == 0u)
+  {
+    segmentsCount = QUANTIS_SHM_SEGMENTS_COUNT;
+  }
+  if ((segmentSize > QUANTIS_MAX_READ_SIZE) ||
+      (segmentsCount < 2u) ||
+      (segmentsCount > QUANTIS_SHM_MAX_SEGMENTS_COUNT))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* Data starts on a page boundary after the header and the segments */
+  segmentsOffset = sizeof(QuantisShmHeader) + segmentsCount * sizeof(QuantisShmSegment);
+  dataOffset = (segmentsOffset + 4095u) & ~(size_t)4095u;
+  mappingSize = dataOffset + (size_t)segmentsCount * segmentSize;
+
+  _producer = (QuantisShmProducer *)calloc(1u, sizeof(QuantisShmProducer));
+  if (!_producer)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  _producer->name = strdup(name);
+  if (!_producer->name)
+  {
+    free(_producer);
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  /* A ring left by a producer that did not exit cleanly is replaced */
+  if (QuantisShmIsActive(name))
+  {
+    result = QUANTIS_ERROR_IO;
+    goto cleanup;
+  }
+  shm_unlink(name);
+  fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    result = QUANTIS_ERROR_IO;
+    goto cleanup;
+  }
+
+  if (ftruncate(fd, (off_t)mappingSize) < 0)
+  {
+    close(fd);
+    shm_unlink(name);
+    result = QUANTIS_ERROR_NO_MEMORY;
+    goto cleanup;
+  }
+
+  mapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    shm_unlink(name);
+    result = QUANTIS_ERROR_NO_MEMORY;
+    goto cleanup;
+  }
+
+  /* The new mapping is zeroed: no consumer, all cursors at 0 */
+  header = (QuantisShmHeader *)mapping;
+  header->version = QUANTIS_SHM_VERSION;
+  header->segmentSize = segmentSize;
+  header->segmentsCount = segmentsCount;
+  header->dataOffset = dataOffset;
+  header->mappingSize = mappingSize;
+  atomic_store(&header->producerPid, (int)getpid());
+  atomic_store(&header->running, 1);
+  atomic_store(&header->current, 0u);
+  for (i = 0u; i < segmentsCount; i++)
+  {
+    /* Epochs 0 to N - 1 are empty: fully reserved and consumed */
+    atomic_store(&header->segments[i].state, QUANTIS_SHM_STATE(i, segmentSize));
+    atomic_store(&header->segments[i].consumed, QUANTIS_SHM_STATE(i, segmentSize));
+  }
+
+  _producer->header = header;
+  _producer->data = (unsigned char *)mapping + dataOffset;
+  _producer->deviceHandle = deviceHandle;
+
+  if (pthread_create(&_producer->thread, NULL, QuantisShmProducerThread, _producer) != 0)
+  {
+    munmap(mapping, mappingSize);
+    shm_unlink(name);
+    result = QUANTIS_ERROR_OTHER;
+    goto cleanup;
+  }
+  _producer->started = 1;
+
+  /* Consumers may open the ring from now on */
+  atomic_store(&header->magic, QUANTIS_SHM_MAGIC);
+
+  *producer = _producer;
+  return QUANTIS_SUCCESS;
+
+cleanup:
+  free(_producer->name);
+  free(_producer);
+  return result;
+}
+
+void QuantisShmDestroy(QuantisShmProducer *producer)
+{
+  if (!producer)
+  {
+    return;
+  }
+
+  atomic_store(&producer->header->running, 0);
+  if (producer->started)
+  {
+    pthread_join(producer->thread, NULL);
+  }
+
+  /* Consumers keep their mapping until they close it */
+  shm_unlink(producer->name);
+  munmap(producer->header, (size_t)producer->header->mappingSize);
+  free(producer->name);
+  free(producer);
+}
+
+int QuantisShmOpen(const char *name,
+                   QuantisShmConsumer **consumer)
+{
+  QuantisShmConsumer *_consumer = NULL;
+  QuantisShmHeader *header;
+  struct stat status;
+  void *mapping;
+  size_t mappingSize;
+  unsigned int i;
+  int pid = (int)getpid();
+  int fd;
+
+  if (!consumer)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *consumer = NULL;
+
+  if (!name)
+  {
+    name = QUANTIS_SHM_DEFAULT_NAME;
+  }
+
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0)
+  {
+    return QUANTIS_ERROR_NO_DEVICE;
+  }
+
+  if ((fstat(fd, &status) < 0) || ((size_t)status.st_size < sizeof(QuantisShmHeader)))
+  {
+    close(fd);
+    return QUANTIS_ERROR_NO_DEVICE;
+  }
+  mappingSize = (size_t)status.st_size;
+
+  mapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  header = (QuantisShmHeader *)mapping;
+  if ((atomic_load(&header->magic) != QUANTIS_SHM_MAGIC) ||
+      (header->version != QUANTIS_SHM_VERSION) ||
+      (header->mappingSize != mappingSize))
+  {
+    munmap(mapping, mappingSize);
+    return QUANTIS_ERROR_NO_DEVICE;
+  }
+
+  _consumer = (QuantisShmConsumer *)calloc(1u, sizeof(QuantisShmConsumer));
+  if (!_consumer)
+  {
+    munmap(mapping, mappingSize);
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+  _consumer->header = header;
+  _consumer->data = (unsigned char *)mapping + header->dataOffset;
+  _consumer->mappingSize = mappingSize;
+
+  /* Claims a free slot */
+  for (i = 0u; (i < QUANTIS_SHM_MAX_CONSUMERS) && !_consumer->slot; i++)
+  {
+    int freePid = 0;
+    if (atomic_compare_exchange_strong(&header->consumers[i].pid, &freePid, pid))
+    {
+      _consumer->slot = &header->consumers[i];
+      atomic_store(&_consumer->slot->reservedSize, 0u);
+      atomic_store(&_consumer->slot->bytesConsumed, 0u);
+    }
+  }
+
+  if (!_consumer->slot)
+  {
+    QuantisShmClose(_consumer);
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  *consumer = _consumer;
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisShmClose(QuantisShmConsumer *consumer)
+{
+  if (!consumer)
+  {
+    return;
+  }
+
+  if (consumer->slot)
+  {
+    atomic_store(&consumer->slot->pid, 0);
+  }
+  munmap(consumer->header, consumer->mappingSize);
+  free(consumer);
+}
+
+int QuantisShmRead(QuantisShmConsumer *consumer, void *buffer, size_t size)
+{
+  QuantisShmHeader *header;
+  unsigned char *output = (unsigned char *)buffer;
+  size_t segmentSize;
+  size_t readBytes = 0u;
+  unsigned int waits = 0u;
+
+  if (!consumer)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (size > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  header = consumer->header;
+  segmentSize = (size_t)header->segmentSize;
+
+  while (readBytes < size)
+  {
+    uint64_t epoch = atomic_load(&header->current);
+    QuantisShmSegment *segment = QuantisShmGetSegment(header, epoch);
+    uint64_t state = atomic_load(&segment->state);
+    unsigned char *data;
+    size_t chunkSize;
+    size_t offset;
+    int error;
+
+    if (QUANTIS_SHM_STATE_EPOCH(state) != (epoch & QUANTIS_SHM_EPOCH_MASK))
+    {
+      /* The segment is ahead: epoch has been consumed already */
+      if (QuantisShmIsPublished(header, epoch))
+      {
+        atomic_compare_exchange_strong(&header->current, &epoch, epoch + 1u);
+        continue;
+      }
+
+      /* The segment is behind: epoch is not filled yet */
+      error = atomic_exchange(&header->error, 0);
+      if (error != 0)
+      {
+        return error;
+      }
+
+      if (!atomic_load(&header->running) ||
+          ((waits >= QUANTIS_SHM_SPINS + QUANTIS_SHM_YIELDS) &&
+           QuantisShmIsProcessDead(atomic_load(&header->producerPid))))
+      {
+        return QUANTIS_ERROR_IO;
+      }
+
+      QuantisShmBackoff(&waits);
+      continue;
+    }
+
+    if (QUANTIS_SHM_STATE_OFFSET(state) >= segmentSize)
+    {
+      /* The segment is fully reserved: moves consumers to the next epoch */
+      atomic_compare_exchange_strong(&header->current, &epoch, epoch + 1u);
+      continue;
+    }
+
+    /* Shows the segment being reserved in case this process dies meanwhile */
+    atomic_store(&consumer->slot->reservedEpoch, epoch);
+    atomic_store(&consumer->slot->reservedSize, QUANTIS_SHM_RESERVATION_PENDING);
+
+    /*
+     * Reserves bytes, the reservation tells which epoch they belong to: the
+     * segment may have been consumed and published again since it was loaded.
+     */
+    chunkSize = size - readBytes;
+    if (chunkSize > segmentSize)
+    {
+      chunkSize = segmentSize;
+    }
+    state = atomic_fetch_add(&segment->state, (uint64_t)chunkSize);
+    offset = (size_t)QUANTIS_SHM_STATE_OFFSET(state);
+    if (offset >= segmentSize)
+    {
+      atomic_store(&consumer->slot->reservedSize, 0u);
+      continue;
+    }
+    if (chunkSize > segmentSize - offset)
+    {
+      chunkSize = segmentSize - offset;
+    }
+    epoch += (QUANTIS_SHM_STATE_EPOCH(state) - epoch) & QUANTIS_SHM_EPOCH_MASK;
+
+    /* Records the reservation in case this process dies while copying it */
+    atomic_store(&consumer->slot->reservedEpoch, epoch);
+    atomic_store(&consumer->slot->reservedSize, chunkSize);
+
+    /* Copies the bytes out and invalidates them */
+    data = consumer->data + (size_t)(epoch % header->segmentsCount) * segmentSize + offset;
+    memcpy(output + readBytes, data, chunkSize);
+    memset(data, 0, chunkSize);
+    readBytes += chunkSize;
+
+    /* The producer may release the reservation of a dead process meanwhile */
+    if (atomic_exchange(&consumer->slot->reservedSize, 0u) != 0u)
+    {
+      QuantisShmConsume(header, epoch, chunkSize);
+    }
+    atomic_fetch_add(&consumer->slot->bytesConsumed, chunkSize);
+    waits = 0u;
+  }
+
+  return (int)readBytes;
+}
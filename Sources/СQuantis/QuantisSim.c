@@ -0,0 +1,722 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#ifndef DISABLE_QUANTIS_SIM
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Quantis.h"
+#include "Quantis_Internal.h"
+
+/* Driver version of the simulator */
+#define DRIVER_VERSION 1.0f
+
+/* Board version reported by simulated devices */
+#define QUANTIS_SIM_BOARD_VERSION 0x51530001
+
+/* Maximal number of modules of a simulated device */
+#define QUANTIS_SIM_MAX_MODULES_COUNT 4
+
+/* Default size (in bytes) of a transfer */
+#define QUANTIS_SIM_TRANSFER_SIZE (16 * 1024)
+
+/* Maximal size (in bytes) of a packet */
+#define QUANTIS_SIM_MAX_PACKET_SIZE (64 * 1024)
+
+/* Size (in bytes) of a ChaCha20 block */
+#define CHACHA20_BLOCK_SIZE 64
+
+/* --------------------- Internal Methods & structures --------------------- */
+
+/**
+ * QuantisDeviceHandlePrivateData for the Quantis simulator
+ */
+typedef struct QuantisPrivateData
+{
+  /* Configuration at the time the device was opened */
+  QuantisSimConfig config;
+
+  char serialNumber[32];
+  int modulesMask;
+
+  /* Data source: a file when fd is valid, ChaCha20 otherwise */
+  int fd;
+  uint32_t chachaState[16];
+  unsigned char chachaBlock[CHACHA20_BLOCK_SIZE];
+  size_t chachaOffset;
+
+  /*
+   * State of the generator deciding status failures. The status may be
+   * requested concurrently (e.g. by the background status monitor).
+   */
+  atomic_uint_fast64_t statusRandom;
+
+  /* Transfers */
+  size_t transferSize;
+  unsigned int transfersCount;
+
+  /* Time (in nanoseconds) until which the device is busy */
+  uint64_t busyUntil;
+} QuantisPrivateData;
+
+/* Configuration of devices opened afterwards, protected by simConfigLock */
+static pthread_mutex_t simConfigLock = PTHREAD_MUTEX_INITIALIZER;
+static char simSourceFile[4096];
+static QuantisSimConfig simConfig =
+    {
+        /*.devicesCount = */ 1u,
+        /*.modulesCount = */ 1u,
+        /*.moduleDataRate = */ QUANTIS_MODULE_DATA_RATE,
+        /*.transferLatency = */ 0u,
+        /*.packetSize = */ 512u,
+        /*.statusFailureRate = */ 0.0,
+        /*.sourceFile = */ NULL,
+        /*.seed = */ 0u};
+
+/* Returns a monotonic time in nanoseconds */
+static uint64_t QuantisSimGetTimeNs()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * UINT64_C(1000000000) + (uint64_t)now.tv_nsec;
+}
+
+/* splitmix64, used to expand seeds */
+static uint64_t QuantisSimSplitMix64(uint64_t *state)
+{
+  uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+  return z ^ (z >> 31);
+}
+
+#define CHACHA20_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA20_QUARTER_ROUND(a, b, c, d) \
+  a += b;                                  \
+  d ^= a;                                  \
+  d = CHACHA20_ROTL(d, 16);                \
+  c += d;                                  \
+  b ^= c;                                  \
+  b = CHACHA20_ROTL(b, 12);                \
+  a += b;                                  \
+  d ^= a;                                  \
+  d = CHACHA20_ROTL(d, 8);                 \
+  c += d;                                  \
+  b ^= c;                                  \
+  b = CHACHA20_ROTL(b, 7);
+
+/* Computes the next ChaCha20 block into output */
+static void QuantisSimChaCha20Block(uint32_t state[16], unsigned char *output)
+{
+  uint32_t x[16];
+  int i;
+
+  memcpy(x, state, sizeof(x));
+  for (i = 0; i < 10; i++)
+  {
+    CHACHA20_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+    CHACHA20_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+    CHACHA20_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+    CHACHA20_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+    CHACHA20_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+    CHACHA20_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+    CHACHA20_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+    CHACHA20_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+  }
+
+  for (i = 0; i < 16; i++)
+  {
+    uint32_t v = x[i] + state[i];
+    output[4 * i + 0] = (unsigned char)(v);
+    output[4 * i + 1] = (unsigned char)(v >> 8);
+    output[4 * i + 2] = (unsigned char)(v >> 16);
+    output[4 * i + 3] = (unsigned char)(v >> 24);
+  }
+
+  /*
+   * 64-bit block counter in words 12-13 (original ChaCha layout rather than
+   * the 32-bit counter of RFC 8439), so that the keystream does not repeat
+   * after 256 GiB of output.
+   */
+  if (++state[12] == 0u)
+  {
+    state[13]++;
+  }
+}
+
+/* Initializes the ChaCha20 generator of the device */
+static int QuantisSimSeed(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  uint32_t key[8];
+  uint64_t seedState;
+  int i;
+
+  if (_privateData->config.seed != 0u)
+  {
+    /* Reproducible stream, distinct for each device number */
+    seedState = _privateData->config.seed;
+    for (i = 0; i < 8; i += 2)
+    {
+      uint64_t v = QuantisSimSplitMix64(&seedState);
+      key[i] = (uint32_t)v;
+      key[i + 1] = (uint32_t)(v >> 32);
+    }
+  }
+  else
+  {
+    size_t readBytes = 0u;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0)
+    {
+      return QUANTIS_ERROR_IO;
+    }
+    while (readBytes < sizeof(key))
+    {
+      ssize_t result = read(fd, (unsigned char *)key + readBytes, sizeof(key) - readBytes);
+      if (result < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (result <= 0)
+      {
+        close(fd);
+        return QUANTIS_ERROR_IO;
+      }
+      readBytes += (size_t)result;
+    }
+    close(fd);
+    seedState = ((uint64_t)key[0] << 32) | key[1];
+  }
+
+  /* "expand 32-byte k" */
+  _privateData->chachaState[0] = 0x61707865u;
+  _privateData->chachaState[1] = 0x3320646eu;
+  _privateData->chachaState[2] = 0x79622d32u;
+  _privateData->chachaState[3] = 0x6b206574u;
+  memcpy(&_privateData->chachaState[4], key, sizeof(key));
+  _privateData->chachaState[12] = 0u;
+  _privateData->chachaState[13] = 0u;
+  _privateData->chachaState[14] = (uint32_t)deviceHandle->deviceNumber;
+  _privateData->chachaState[15] = 0u;
+  _privateData->chachaOffset = CHACHA20_BLOCK_SIZE;
+
+  atomic_init(&_privateData->statusRandom, QuantisSimSplitMix64(&seedState));
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Fills buffer with size bytes of the data source */
+static int QuantisSimGenerate(QuantisPrivateData *_privateData,
+                              unsigned char *buffer,
+                              size_t size)
+{
+  size_t readBytes = 0u;
+
+  if (_privateData->fd >= 0)
+  {
+    /* The file is read in loop */
+    while (readBytes < size)
+    {
+      ssize_t result = read(_privateData->fd, buffer + readBytes, size - readBytes);
+      if (result < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        return QUANTIS_ERROR_IO;
+      }
+      else if (result == 0)
+      {
+        if (lseek(_privateData->fd, 0, SEEK_SET) < 0)
+        {
+          return QUANTIS_ERROR_IO;
+        }
+        continue;
+      }
+      readBytes += (size_t)result;
+    }
+
+    return QUANTIS_SUCCESS;
+  }
+
+  /* Remaining of the current block */
+  while ((readBytes < size) && (_privateData->chachaOffset < CHACHA20_BLOCK_SIZE))
+  {
+    buffer[readBytes++] = _privateData->chachaBlock[_privateData->chachaOffset++];
+  }
+
+  /* Whole blocks are written directly to the buffer */
+  while (size - readBytes >= CHACHA20_BLOCK_SIZE)
+  {
+    QuantisSimChaCha20Block(_privateData->chachaState, buffer + readBytes);
+    readBytes += CHACHA20_BLOCK_SIZE;
+  }
+
+  if (readBytes < size)
+  {
+    QuantisSimChaCha20Block(_privateData->chachaState, _privateData->chachaBlock);
+    _privateData->chachaOffset = size - readBytes;
+    memcpy(buffer + readBytes, _privateData->chachaBlock, size - readBytes);
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Waits for the time the device needs to transfer size bytes */
+static void QuantisSimWait(QuantisDeviceHandle *deviceHandle, size_t size)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  uint64_t now = QuantisSimGetTimeNs();
+  uint64_t duration = 0u;
+  uint64_t dataRate;
+  int modulesCount = QuantisCountSetBits(_privateData->modulesMask);
+
+  /* Transfers in flight hide the latency of each other */
+  duration += (uint64_t)_privateData->config.transferLatency * 1000u / _privateData->transfersCount;
+
+  dataRate = (uint64_t)_privateData->config.moduleDataRate * (uint64_t)modulesCount;
+  if (dataRate > 0u)
+  {
+    duration += (uint64_t)size * UINT64_C(1000000000) / dataRate;
+  }
+
+  if (_privateData->busyUntil < now)
+  {
+    _privateData->busyUntil = now;
+  }
+  _privateData->busyUntil += duration;
+
+  if (_privateData->busyUntil > now)
+  {
+    uint64_t delay = _privateData->busyUntil - now;
+    struct timespec request;
+    request.tv_sec = (time_t)(delay / UINT64_C(1000000000));
+    request.tv_nsec = (long)(delay % UINT64_C(1000000000));
+    while ((nanosleep(&request, &request) < 0) && (errno == EINTR))
+    {
+    }
+  }
+}
+
+/* ---------------------------- Public Methods ----------------------------- */
+
+int QuantisSimSetConfig(const QuantisSimConfig *config)
+{
+  if (!config ||
+      (config->devicesCount > MAX_QUANTIS_DEVICE) ||
+      (config->modulesCount < 1u) ||
+      (config->modulesCount > QUANTIS_SIM_MAX_MODULES_COUNT) ||
+      (config->packetSize < 1u) ||
+      (config->packetSize > QUANTIS_SIM_MAX_PACKET_SIZE) ||
+      !(config->statusFailureRate >= 0.0) ||
+      (config->statusFailureRate > 1.0))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  if (config->sourceFile && (strlen(config->sourceFile) >= sizeof(simSourceFile)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  pthread_mutex_lock(&simConfigLock);
+  simConfig = *config;
+  if (config->sourceFile)
+  {
+    strcpy(simSourceFile, config->sourceFile);
+    simConfig.sourceFile = simSourceFile;
+  }
+  pthread_mutex_unlock(&simConfigLock);
+
+  return QUANTIS_SUCCESS;
+}
+
+void QuantisSimGetConfig(QuantisSimConfig *config)
+{
+  if (!config)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&simConfigLock);
+  *config = simConfig;
+  pthread_mutex_unlock(&simConfigLock);
+}
+
+/* BoardReset */
+int QuantisSimBoardReset(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+
+  /* Enables all the modules back */
+  _privateData->modulesMask = (1 << _privateData->config.modulesCount) - 1;
+  _privateData->busyUntil = 0u;
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Close */
+void QuantisSimClose(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+
+  if (!_privateData)
+  {
+    return;
+  }
+
+  if (_privateData->fd >= 0)
+  {
+    close(_privateData->fd);
+  }
+
+  free(_privateData);
+  deviceHandle->privateData = NULL;
+}
+
+/* Count */
+int QuantisSimCount()
+{
+  int count;
+
+  pthread_mutex_lock(&simConfigLock);
+  count = (int)simConfig.devicesCount;
+  pthread_mutex_unlock(&simConfigLock);
+
+  return count;
+}
+
+/* GetBoardVersion */
+int QuantisSimGetBoardVersion(QuantisDeviceHandle *deviceHandle)
+{
+  deviceHandle = deviceHandle; /* Avoids unused parameter warning */
+  return QUANTIS_SIM_BOARD_VERSION;
+}
+
+/* GetDriverVersion */
+float QuantisSimGetDriverVersion()
+{
+  return DRIVER_VERSION;
+}
+
+/* GetManufacturer */
+char *QuantisSimGetManufacturer(QuantisDeviceHandle *deviceHandle)
+{
+  deviceHandle = deviceHandle; /* Avoids unused parameter warning */
+  return (char *)"Quantis simulator";
+}
+
+/* GetModulesMask */
+int QuantisSimGetModulesMask(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  return (1 << _privateData->config.modulesCount) - 1;
+}
+
+/* GetModulesDataRate */
+int QuantisSimGetModulesDataRate(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  return (int)_privateData->config.moduleDataRate * QuantisCountSetBits(_privateData->modulesMask);
+}
+
+/* GetModulesPower */
+int QuantisSimGetModulesPower(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  return (_privateData->modulesMask != 0) ? 1 : 0;
+}
+
+/* GetModulesStatus */
+int QuantisSimGetModulesStatus(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+
+  if (_privateData->config.statusFailureRate > 0.0)
+  {
+    uint64_t state = atomic_load(&_privateData->statusRandom);
+    uint64_t nextState;
+    uint64_t random;
+    double draw;
+
+    /* Each caller gets its own draw of the sequence */
+    do
+    {
+      nextState = state;
+      random = QuantisSimSplitMix64(&nextState);
+    } while (!atomic_compare_exchange_weak(&_privateData->statusRandom, &state, nextState));
+
+    /* Uniform double in [0, 1) */
+    draw = (double)(random >> 11) / 9007199254740992.0;
+    if (draw < _privateData->config.statusFailureRate)
+    {
+      return 0;
+    }
+  }
+
+  return _privateData->modulesMask;
+}
+
+/* GetSerialNumber */
+char *QuantisSimGetSerialNumber(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  return _privateData->serialNumber;
+}
+
+/* ModulesDisable */
+int QuantisSimModulesDisable(QuantisDeviceHandle *deviceHandle, int moduleMask)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+
+  if ((moduleMask & ~QuantisSimGetModulesMask(deviceHandle)) != 0)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  _privateData->modulesMask &= ~moduleMask;
+
+  return QUANTIS_SUCCESS;
+}
+
+/* ModulesEnable */
+int QuantisSimModulesEnable(QuantisDeviceHandle *deviceHandle, int moduleMask)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+
+  if ((moduleMask & ~QuantisSimGetModulesMask(deviceHandle)) != 0)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  _privateData->modulesMask |= moduleMask;
+
+  return QUANTIS_SUCCESS;
+}
+
+/* GetAis31StartupTestsRequestFlag */
+int QuantisSimGetAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle)
+{
+  deviceHandle = deviceHandle; /* Avoids unused parameter warning */
+  return 0;
+}
+
+/* ClearAis31StartupTestsRequestFlag */
+int QuantisSimClearAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle)
+{
+  deviceHandle = deviceHandle; /* Avoids unused parameter warning */
+  return QUANTIS_SUCCESS;
+}
+
+/* Open */
+int QuantisSimOpen(QuantisDeviceHandle *deviceHandle)
+{
+  int result = QUANTIS_SUCCESS;
+  QuantisPrivateData *_privateData = NULL;
+
+  _privateData = (QuantisPrivateData *)calloc(1u, sizeof(QuantisPrivateData));
+  if (!_privateData)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+  _privateData->fd = -1;
+  deviceHandle->privateData = _privateData;
+
+  /* Each device keeps the configuration it was opened with */
+  pthread_mutex_lock(&simConfigLock);
+  _privateData->config = simConfig;
+  if (simConfig.sourceFile)
+  {
+    _privateData->fd = open(simConfig.sourceFile, O_RDONLY);
+    if (_privateData->fd < 0)
+    {
+      result = QUANTIS_ERROR_IO;
+    }
+  }
+  pthread_mutex_unlock(&simConfigLock);
+  _privateData->config.sourceFile = NULL;
+
+  if (result < 0)
+  {
+    goto cleanup;
+  }
+
+  if ((deviceHandle->deviceNumber < 0) ||
+      ((unsigned int)deviceHandle->deviceNumber >= _privateData->config.devicesCount))
+  {
+    result = QUANTIS_ERROR_NO_DEVICE;
+    goto cleanup;
+  }
+
+  result = QuantisSimSeed(deviceHandle);
+  if (result < 0)
+  {
+    goto cleanup;
+  }
+
+  snprintf(_privateData->serialNumber,
+           sizeof(_privateData->serialNumber),
+           "SIM%08d",
+           deviceHandle->deviceNumber);
+  _privateData->modulesMask = (1 << _privateData->config.modulesCount) - 1;
+  _privateData->transferSize = QUANTIS_SIM_TRANSFER_SIZE;
+  _privateData->transfersCount = 1u;
+
+  return QUANTIS_SUCCESS;
+
+cleanup:
+  QuantisSimClose(deviceHandle);
+  return result;
+}
+
+/* Read */
+int QuantisSimRead(QuantisDeviceHandle *deviceHandle, void *buffer, size_t size)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  size_t packetSize = _privateData->config.packetSize;
+  size_t readBytes = 0u;
+  int result;
+
+  if (_privateData->modulesMask == 0)
+  {
+    return QUANTIS_ERROR_NO_MODULE;
+  }
+
+  while (readBytes < size)
+  {
+    size_t transferSize = size - readBytes;
+    if (transferSize > _privateData->transferSize)
+    {
+      transferSize = _privateData->transferSize;
+    }
+
+    /* Check if status is ok */
+    result = QuantisCheckStatusInternal(deviceHandle, transferSize);
+    if (result < 0)
+    {
+      return result;
+    }
+
+    result = QuantisSimGenerate(_privateData, (unsigned char *)buffer + readBytes, transferSize);
+    if (result < 0)
+    {
+      return result;
+    }
+
+    /* The device only sends whole packets */
+    QuantisSimWait(deviceHandle, (transferSize + packetSize - 1u) / packetSize * packetSize);
+
+    readBytes += transferSize;
+  }
+
+  return (int)readBytes;
+}
+
+/* GetBusDeviceId */
+int QuantisSimGetBusDeviceId(QuantisDeviceHandle *deviceHandle)
+{
+  deviceHandle = deviceHandle; /* Avoids unused parameter warning */
+  return 0;
+}
+
+char *QuantisSimTypeStrError(int errorNumber)
+{
+  errorNumber = errorNumber; /* Avoids unused parameter warning */
+  return NULL;
+}
+
+/* SetReadPipeline */
+int QuantisSimSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                              size_t transferSize,
+                              unsigned int transfersCount)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  size_t packetSize = _privateData->config.packetSize;
+
+  if (transferSize == 0u)
+  {
+    transferSize = QUANTIS_SIM_TRANSFER_SIZE;
+  }
+  if (transfersCount == 0u)
+  {
+    transfersCount = 1u;
+  }
+  if (transferSize > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  _privateData->transferSize = (transferSize + packetSize - 1u) / packetSize * packetSize;
+  _privateData->transfersCount = transfersCount;
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Rescan */
+int QuantisSimRescan()
+{
+  return QuantisSimCount();
+}
+
+#else
+int unusedQuantisSim; /* Silence `ISO C forbids an empty translation unit' warning.  */
+#endif /* DISABLE_QUANTIS_SIM */
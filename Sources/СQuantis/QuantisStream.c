@@ -0,0 +1,286 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Quantis.h"
+
+/* Default size of the chunks passed to the callback */
+#define QUANTIS_STREAM_DEFAULT_CHUNK_SIZE (1024u * 1024u)
+
+/* The device reads a chunk while the callback consumes the other */
+#define QUANTIS_STREAM_BUFFERS_COUNT 2u
+
+typedef struct QuantisStreamBuffer
+{
+  unsigned char *data;
+  size_t size;
+  int result;
+  int full;
+} QuantisStreamBuffer;
+
+typedef struct QuantisStream
+{
+  QuantisDeviceHandle *deviceHandle;
+  QuantisStreamBuffer buffers[QUANTIS_STREAM_BUFFERS_COUNT];
+  size_t chunkSize;
+
+  /* Number of bytes left to read, unless unlimited */
+  unsigned long long remaining;
+  int unlimited;
+
+  pthread_mutex_t lock;
+  pthread_cond_t filledCond;
+  pthread_cond_t emptiedCond;
+  int stopped;
+} QuantisStream;
+
+static void *QuantisStreamReaderThread(void *arg)
+{
+  QuantisStream *stream = (QuantisStream *)arg;
+  unsigned int index = 0u;
+
+  for (;;)
+  {
+    QuantisStreamBuffer *buffer = &stream->buffers[index];
+    size_t size = stream->chunkSize;
+    int result;
+
+    if (!stream->unlimited)
+    {
+      if (stream->remaining == 0u)
+      {
+        break;
+      }
+      if (stream->remaining < size)
+      {
+        size = (size_t)stream->remaining;
+      }
+      stream->remaining -= size;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    while (buffer->full && !stream->stopped)
+    {
+      pthread_cond_wait(&stream->emptiedCond, &stream->lock);
+    }
+    if (stream->stopped)
+    {
+      pthread_mutex_unlock(&stream->lock);
+      break;
+    }
+    pthread_mutex_unlock(&stream->lock);
+
+    /* The buffer belongs to this thread until it is marked full */
+    result = QuantisReadHandled(stream->deviceHandle, buffer->data, size);
+    if ((result >= 0) && ((size_t)result != size))
+    {
+      result = QUANTIS_ERROR_IO;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    buffer->size = size;
+    buffer->result = result;
+    buffer->full = 1;
+    pthread_cond_signal(&stream->filledCond);
+    pthread_mutex_unlock(&stream->lock);
+
+    if (result < 0)
+    {
+      break;
+    }
+    index = (index + 1u) % QUANTIS_STREAM_BUFFERS_COUNT;
+  }
+
+  return NULL;
+}
+
+int QuantisReadStreamHandled(QuantisDeviceHandle *deviceHandle,
+                             unsigned long long size,
+                             size_t chunkSize,
+                             QuantisStreamCallback callback,
+                             void *userData)
+{
+  QuantisStream stream;
+  pthread_t reader;
+  unsigned long long delivered = 0u;
+  unsigned int index = 0u;
+  unsigned int i;
+  int result = QUANTIS_SUCCESS;
+
+  if (deviceHandle == NULL)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if (callback == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  if (chunkSize == 0u)
+  {
+    chunkSize = QUANTIS_STREAM_DEFAULT_CHUNK_SIZE;
+  }
+  if (chunkSize > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  /* Small streams do not need a full chunk */
+  if ((size != 0u) && (size < chunkSize))
+  {
+    chunkSize = (size_t)size;
+  }
+
+  memset(&stream, 0, sizeof(stream));
+  stream.deviceHandle = deviceHandle;
+  stream.chunkSize = chunkSize;
+  stream.remaining = size;
+  stream.unlimited = (size == 0u);
+
+  for (i = 0u; i < QUANTIS_STREAM_BUFFERS_COUNT; i++)
+  {
+    stream.buffers[i].data = (unsigned char *)malloc(chunkSize);
+    if (stream.buffers[i].data == NULL)
+    {
+      result = QUANTIS_ERROR_NO_MEMORY;
+      goto cleanup;
+    }
+  }
+
+  pthread_mutex_init(&stream.lock, NULL);
+  pthread_cond_init(&stream.filledCond, NULL);
+  pthread_cond_init(&stream.emptiedCond, NULL);
+
+  if (pthread_create(&reader, NULL, QuantisStreamReaderThread, &stream) != 0)
+  {
+    result = QUANTIS_ERROR_OTHER;
+    goto cleanup_sync;
+  }
+
+  while (stream.unlimited || (delivered < size))
+  {
+    QuantisStreamBuffer *buffer = &stream.buffers[index];
+    int stop;
+
+    pthread_mutex_lock(&stream.lock);
+    while (!buffer->full)
+    {
+      pthread_cond_wait(&stream.filledCond, &stream.lock);
+    }
+    pthread_mutex_unlock(&stream.lock);
+
+    if (buffer->result < 0)
+    {
+      result = buffer->result;
+      break;
+    }
+
+    /* The reader fills the other buffer meanwhile */
+    stop = callback(buffer->data, buffer->size, userData);
+    delivered += buffer->size;
+
+    pthread_mutex_lock(&stream.lock);
+    buffer->full = 0;
+    pthread_cond_signal(&stream.emptiedCond);
+    pthread_mutex_unlock(&stream.lock);
+
+    if (stop)
+    {
+      break;
+    }
+    index = (index + 1u) % QUANTIS_STREAM_BUFFERS_COUNT;
+  }
+
+  pthread_mutex_lock(&stream.lock);
+  stream.stopped = 1;
+  pthread_cond_signal(&stream.emptiedCond);
+  pthread_mutex_unlock(&stream.lock);
+  pthread_join(reader, NULL);
+
+cleanup_sync:
+  pthread_cond_destroy(&stream.emptiedCond);
+  pthread_cond_destroy(&stream.filledCond);
+  pthread_mutex_destroy(&stream.lock);
+
+cleanup:
+  for (i = 0u; i < QUANTIS_STREAM_BUFFERS_COUNT; i++)
+  {
+    free(stream.buffers[i].data);
+  }
+
+  return result;
+}
+
+int QuantisReadStream(QuantisDeviceType deviceType,
+                      unsigned int deviceNumber,
+                      unsigned long long size,
+                      size_t chunkSize,
+                      QuantisStreamCallback callback,
+                      void *userData)
+{
+  QuantisDeviceHandle *deviceHandle = NULL;
+  int result;
+
+  result = QuantisOpen(deviceType, deviceNumber, &deviceHandle);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  result = QuantisReadStreamHandled(deviceHandle, size, chunkSize, callback, userData);
+
+  QuantisClose(deviceHandle);
+
+  return result;
+}
@@ -0,0 +1,755 @@
+/*
+ * Quantis C library
+ *
+ * Copyright (C) 2004-2020 ID Quantique SA, Carouge/Geneva, Switzerland
+ * All rights reserved.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Alternatively, this software may be distributed under the terms of the
+ * GNU General Public License version 2 as published by the Free Software 
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * For history of changes, see ChangeLog.txt
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define QUANTIS_HAVE_IO_URING
+#endif
+#endif
+
+#ifdef QUANTIS_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Quantis.h"
+#include "Quantis_Internal.h"
+
+/* Default size (in bytes) of a read queued to a device */
+#define QUANTIS_URING_TRANSFER_SIZE (64 * 1024)
+
+/* Default number of reads in flight */
+#define QUANTIS_URING_TRANSFERS_COUNT 16
+
+/* Maximal number of reads in flight */
+#define QUANTIS_URING_MAX_TRANSFERS_COUNT 1024
+
+/* user_data of the requests cancelling reads, which have no slot */
+#define QUANTIS_URING_CANCEL_DATA UINT64_MAX
+
+/* A device read by the engine */
+typedef struct QuantisUringDevice
+{
+  QuantisDeviceHandle *deviceHandle;
+  int fd;
+} QuantisUringDevice;
+
+/* A buffer of transferSize bytes, read into by a single read at a time */
+typedef struct QuantisUringSlot
+{
+  /* Bytes read into the slot and bytes of them already copied out */
+  size_t length;
+  size_t offset;
+
+  int inFlight;
+} QuantisUringSlot;
+
+/**
+ * Reads are queued on all the devices at once into transfersCount slots,
+ * and the slots are copied out in the order their reads complete. Slots
+ * are either free, in flight, or ready (holding random data not copied out
+ * yet). Reads stay in flight between calls of QuantisUringRead, so the
+ * devices keep working while the caller uses the data.
+ *
+ * When io_uring is not available, devices are read in turn with
+ * QuantisReadHandled (fallback is set).
+ */
+struct QuantisUring
+{
+  QuantisUringDevice *devices;
+  unsigned int devicesCount;
+  unsigned int nextDevice;
+
+  size_t transferSize;
+  unsigned int transfersCount;
+
+  QuantisBuffer memory;
+  QuantisUringSlot *slots;
+  struct iovec *iovecs;
+
+  /* Ready slots, in completion order (circular) */
+  unsigned int *readySlots;
+  unsigned int readyHead;
+  unsigned int readyCount;
+
+  /* Free slots (stack) */
+  unsigned int *freeSlots;
+  unsigned int freeCount;
+
+  unsigned int inFlight;
+
+  /* Error of a failed read, kept until returned by QuantisUringRead */
+  int error;
+
+  int fallback;
+
+#ifdef QUANTIS_HAVE_IO_URING
+  int ringFd;
+  int fixedBuffers;
+  int fixedFiles;
+  unsigned int toSubmit;
+
+  void *sqRing;
+  size_t sqRingSize;
+  unsigned int *sqHead;
+  unsigned int *sqTail;
+  unsigned int *sqMask;
+  unsigned int *sqArray;
+  struct io_uring_sqe *sqes;
+  size_t sqesSize;
+
+  void *cqRing;
+  size_t cqRingSize;
+  unsigned int *cqHead;
+  unsigned int *cqTail;
+  unsigned int *cqMask;
+  struct io_uring_cqe *cqes;
+#endif
+};
+
+#ifdef QUANTIS_HAVE_IO_URING
+
+static int QuantisUringSetup(unsigned int entries, struct io_uring_params *params)
+{
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int QuantisUringEnter(int ringFd,
+                             unsigned int toSubmit,
+                             unsigned int minComplete,
+                             unsigned int flags)
+{
+  return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static int QuantisUringRegister(int ringFd,
+                                unsigned int opcode,
+                                const void *arg,
+                                unsigned int count)
+{
+  return (int)syscall(__NR_io_uring_register, ringFd, opcode, arg, count);
+}
+
+/* Maps the rings of a new io_uring instance */
+static int QuantisUringMapRings(QuantisUring *uring)
+{
+  struct io_uring_params params;
+  unsigned char *sqRing;
+  unsigned char *cqRing;
+
+  memset(&params, 0, sizeof(params));
+  uring->ringFd = QuantisUringSetup(uring->transfersCount, &params);
+  if (uring->ringFd < 0)
+  {
+    /* ENOSYS on old kernels, EPERM when disabled (kernel.io_uring_disabled) */
+    return QUANTIS_ERROR_OPERATION_NOT_SUPPORTED;
+  }
+
+  uring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  uring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    if (uring->cqRingSize > uring->sqRingSize)
+    {
+      uring->sqRingSize = uring->cqRingSize;
+    }
+    uring->cqRingSize = uring->sqRingSize;
+  }
+
+  sqRing = (unsigned char *)mmap(NULL, uring->sqRingSize, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, uring->ringFd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+  uring->sqRing = sqRing;
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    cqRing = sqRing;
+  }
+  else
+  {
+    cqRing = (unsigned char *)mmap(NULL, uring->cqRingSize, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE, uring->ringFd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED)
+    {
+      return QUANTIS_ERROR_NO_MEMORY;
+    }
+  }
+  uring->cqRing = cqRing;
+
+  uring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  uring->sqes = (struct io_uring_sqe *)mmap(NULL, uring->sqesSize, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, uring->ringFd, IORING_OFF_SQES);
+  if (uring->sqes == MAP_FAILED)
+  {
+    uring->sqes = NULL;
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  uring->sqHead = (unsigned int *)(sqRing + params.sq_off.head);
+  uring->sqTail = (unsigned int *)(sqRing + params.sq_off.tail);
+  uring->sqMask = (unsigned int *)(sqRing + params.sq_off.ring_mask);
+  uring->sqArray = (unsigned int *)(sqRing + params.sq_off.array);
+  uring->cqHead = (unsigned int *)(cqRing + params.cq_off.head);
+  uring->cqTail = (unsigned int *)(cqRing + params.cq_off.tail);
+  uring->cqMask = (unsigned int *)(cqRing + params.cq_off.ring_mask);
+  uring->cqes = (struct io_uring_cqe *)(cqRing + params.cq_off.cqes);
+
+  return QUANTIS_SUCCESS;
+}
+
+static void QuantisUringUnmapRings(QuantisUring *uring)
+{
+  if (uring->sqes)
+  {
+    munmap(uring->sqes, uring->sqesSize);
+  }
+  if (uring->cqRing && (uring->cqRing != uring->sqRing))
+  {
+    munmap(uring->cqRing, uring->cqRingSize);
+  }
+  if (uring->sqRing)
+  {
+    munmap(uring->sqRing, uring->sqRingSize);
+  }
+  if (uring->ringFd >= 0)
+  {
+    close(uring->ringFd);
+  }
+}
+
+/* Queues a read of the next device into each free slot */
+static int QuantisUringQueueReads(QuantisUring *uring)
+{
+  while (uring->freeCount > 0u)
+  {
+    unsigned int slotIndex = uring->freeSlots[uring->freeCount - 1u];
+    unsigned int deviceIndex = uring->nextDevice;
+    QuantisUringDevice *device = &uring->devices[deviceIndex];
+    struct io_uring_sqe *sqe;
+    unsigned int tail;
+    int result;
+
+    /* Status of the modules is checked before every transfer */
+    result = QuantisCheckStatusInternal(device->deviceHandle, uring->transferSize);
+    if (result < 0)
+    {
+      return result;
+    }
+
+    tail = *uring->sqTail;
+    sqe = &uring->sqes[tail & *uring->sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+
+    if (uring->fixedBuffers)
+    {
+      sqe->opcode = IORING_OP_READ_FIXED;
+      sqe->addr = (uint64_t)(uintptr_t)uring->iovecs[slotIndex].iov_base;
+      sqe->len = (uint32_t)uring->transferSize;
+      sqe->buf_index = (uint16_t)slotIndex;
+    }
+    else
+    {
+      sqe->opcode = IORING_OP_READV;
+      sqe->addr = (uint64_t)(uintptr_t)&uring->iovecs[slotIndex];
+      sqe->len = 1u;
+    }
+
+    if (uring->fixedFiles)
+    {
+      sqe->fd = (int32_t)deviceIndex;
+      sqe->flags = IOSQE_FIXED_FILE;
+    }
+    else
+    {
+      sqe->fd = device->fd;
+    }
+
+    /* Character devices have no position */
+    sqe->off = 0u;
+    sqe->user_data = slotIndex;
+
+    uring->sqArray[tail & *uring->sqMask] = tail & *uring->sqMask;
+    __atomic_store_n(uring->sqTail, tail + 1u, __ATOMIC_RELEASE);
+
+    uring->slots[slotIndex].inFlight = 1;
+    uring->freeCount--;
+    uring->inFlight++;
+    uring->toSubmit++;
+    uring->nextDevice = (deviceIndex + 1u) % uring->devicesCount;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/*
+ * Submits the queued reads and reaps all the completed ones, waiting for at
+ * least minComplete of them.
+ */
+static int QuantisUringSubmitAndReap(QuantisUring *uring, unsigned int minComplete)
+{
+  unsigned int head;
+  unsigned int tail;
+
+  for (;;)
+  {
+    int result = QuantisUringEnter(uring->ringFd,
+                                   uring->toSubmit,
+                                   minComplete,
+                                   (minComplete > 0u) ? IORING_ENTER_GETEVENTS : 0u);
+    if (result >= 0)
+    {
+      uring->toSubmit -= (unsigned int)result;
+      break;
+    }
+    if ((errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY))
+    {
+      return QUANTIS_ERROR_IO;
+    }
+  }
+
+  /* Reaps completions by batch */
+  head = *uring->cqHead;
+  tail = __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE);
+  while (head != tail)
+  {
+    struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cqMask];
+    unsigned int slotIndex;
+    QuantisUringSlot *slot;
+
+    head++;
+    if (cqe->user_data == QUANTIS_URING_CANCEL_DATA)
+    {
+      continue;
+    }
+
+    slotIndex = (unsigned int)cqe->user_data;
+    slot = &uring->slots[slotIndex];
+    slot->inFlight = 0;
+    uring->inFlight--;
+    if (cqe->res > 0)
+    {
+      slot->length = (size_t)cqe->res;
+      slot->offset = 0u;
+      uring->readySlots[(uring->readyHead + uring->readyCount) % uring->transfersCount] = slotIndex;
+      uring->readyCount++;
+    }
+    else
+    {
+      /* Empty or interrupted reads are simply queued again */
+      if ((cqe->res != 0) && (cqe->res != -EINTR) && (cqe->res != -EAGAIN))
+      {
+        uring->error = QUANTIS_ERROR_IO;
+      }
+      uring->freeSlots[uring->freeCount++] = slotIndex;
+    }
+  }
+  __atomic_store_n(uring->cqHead, head, __ATOMIC_RELEASE);
+
+  return QUANTIS_SUCCESS;
+}
+
+/*
+ * Cancels the reads in flight and waits for them: their slots must not be
+ * released while the kernel may still write to them.
+ */
+static void QuantisUringCancelReads(QuantisUring *uring)
+{
+  unsigned int i;
+
+  for (i = 0u; i < uring->transfersCount; i++)
+  {
+    struct io_uring_sqe *sqe;
+    unsigned int tail;
+
+    if (!uring->slots[i].inFlight)
+    {
+      continue;
+    }
+
+    tail = *uring->sqTail;
+    sqe = &uring->sqes[tail & *uring->sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = i;
+    sqe->user_data = QUANTIS_URING_CANCEL_DATA;
+    uring->sqArray[tail & *uring->sqMask] = tail & *uring->sqMask;
+    __atomic_store_n(uring->sqTail, tail + 1u, __ATOMIC_RELEASE);
+    uring->toSubmit++;
+  }
+
+  /* Reads that could not be cancelled end with the next data of the device */
+  while (uring->inFlight > 0u)
+  {
+    if (QuantisUringSubmitAndReap(uring, 1u) < 0)
+    {
+      break;
+    }
+  }
+}
+
+#endif /* QUANTIS_HAVE_IO_URING */
+
+void QuantisUringDestroy(QuantisUring *uring)
+{
+  if (!uring)
+  {
+    return;
+  }
+
+#ifdef QUANTIS_HAVE_IO_URING
+  if (uring->sqes)
+  {
+    QuantisUringCancelReads(uring);
+  }
+  QuantisUringUnmapRings(uring);
+#endif
+
+  QuantisBufferFree(&uring->memory);
+  free(uring->slots);
+  free(uring->iovecs);
+  free(uring->readySlots);
+  free(uring->freeSlots);
+  free(uring->devices);
+  free(uring);
+}
+
+int QuantisUringCreateInternal(QuantisDeviceHandle **deviceHandles,
+                               const int *fds,
+                               unsigned int devicesCount,
+                               size_t transferSize,
+                               unsigned int transfersCount,
+                               QuantisUring **uring)
+{
+  QuantisUring *_uring = NULL;
+  unsigned int i;
+  int result = QUANTIS_ERROR_NO_MEMORY;
+
+  if (!uring || !deviceHandles || (devicesCount == 0u))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+  *uring = NULL;
+
+  if (transferSize == 0u)
+  {
+    transferSize = QUANTIS_URING_TRANSFER_SIZE;
+  }
+  if (transfersCount == 0u)
+  {
+    transfersCount = QUANTIS_URING_TRANSFERS_COUNT;
+  }
+  if ((transferSize > QUANTIS_MAX_READ_SIZE) || (transfersCount > QUANTIS_URING_MAX_TRANSFERS_COUNT))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  _uring = (QuantisUring *)calloc(1u, sizeof(QuantisUring));
+  if (!_uring)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+#ifdef QUANTIS_HAVE_IO_URING
+  _uring->ringFd = -1;
+#endif
+  _uring->devicesCount = devicesCount;
+  _uring->transferSize = transferSize;
+  _uring->transfersCount = transfersCount;
+  _uring->fallback = (fds == NULL);
+
+  _uring->devices = (QuantisUringDevice *)calloc(devicesCount, sizeof(QuantisUringDevice));
+  if (!_uring->devices)
+  {
+    goto cleanup;
+  }
+  for (i = 0u; i < devicesCount; i++)
+  {
+    if (!deviceHandles[i])
+    {
+      result = QUANTIS_ERROR_IO;
+      goto cleanup;
+    }
+    _uring->devices[i].deviceHandle = deviceHandles[i];
+    _uring->devices[i].fd = fds ? fds[i] : -1;
+  }
+
+  if (_uring->fallback)
+  {
+    *uring = _uring;
+    return QUANTIS_SUCCESS;
+  }
+
+#ifdef QUANTIS_HAVE_IO_URING
+  _uring->slots = (QuantisUringSlot *)calloc(transfersCount, sizeof(QuantisUringSlot));
+  _uring->iovecs = (struct iovec *)calloc(transfersCount, sizeof(struct iovec));
+  _uring->readySlots = (unsigned int *)calloc(transfersCount, sizeof(unsigned int));
+  _uring->freeSlots = (unsigned int *)calloc(transfersCount, sizeof(unsigned int));
+  if (!_uring->slots || !_uring->iovecs || !_uring->readySlots || !_uring->freeSlots)
+  {
+    goto cleanup;
+  }
+
+  if (QuantisBufferAlloc(&_uring->memory,
+                         (size_t)transfersCount * transferSize,
+                         QuantisGetNumaNode(deviceHandles[0])) != QUANTIS_SUCCESS)
+  {
+    goto cleanup;
+  }
+
+  for (i = 0u; i < transfersCount; i++)
+  {
+    _uring->iovecs[i].iov_base = _uring->memory.data + (size_t)i * transferSize;
+    _uring->iovecs[i].iov_len = transferSize;
+    _uring->freeSlots[i] = transfersCount - 1u - i;
+  }
+  _uring->freeCount = transfersCount;
+
+  result = QuantisUringMapRings(_uring);
+  if (result < 0)
+  {
+    goto cleanup;
+  }
+
+  /*
+   * Registered buffers and files save the kernel a lookup per read. They are
+   * optional: registration fails on kernels limiting locked memory.
+   */
+  _uring->fixedBuffers = (QuantisUringRegister(_uring->ringFd, IORING_REGISTER_BUFFERS,
+                                               _uring->iovecs, transfersCount) == 0);
+  _uring->fixedFiles = (QuantisUringRegister(_uring->ringFd, IORING_REGISTER_FILES,
+                                             fds, devicesCount) == 0);
+
+  *uring = _uring;
+  return QUANTIS_SUCCESS;
+#else
+  result = QUANTIS_ERROR_OPERATION_NOT_SUPPORTED;
+#endif /* QUANTIS_HAVE_IO_URING */
+
+cleanup:
+  QuantisUringDestroy(_uring);
+  return result;
+}
+
+int QuantisUringCreate(QuantisDeviceHandle **deviceHandles,
+                       unsigned int deviceHandlesCount,
+                       size_t transferSize,
+                       unsigned int transfersCount,
+                       QuantisUring **uring)
+{
+  int *fds = NULL;
+  unsigned int i;
+  int result;
+
+  if (!uring || !deviceHandles || (deviceHandlesCount == 0u))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  fds = (int *)malloc(deviceHandlesCount * sizeof(int));
+  if (!fds)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  /* Only Quantis PCI devices have a file descriptor */
+  for (i = 0u; i < deviceHandlesCount; i++)
+  {
+    fds[i] = -1;
+#ifndef DISABLE_QUANTIS_PCI
+    if (deviceHandles[i] && (deviceHandles[i]->deviceType == QUANTIS_DEVICE_PCI))
+    {
+      fds[i] = QuantisPciGetFd(deviceHandles[i]);
+    }
+#endif
+    if (fds[i] < 0)
+    {
+      break;
+    }
+  }
+
+  result = QUANTIS_ERROR_OPERATION_NOT_SUPPORTED;
+  if (i == deviceHandlesCount)
+  {
+    result = QuantisUringCreateInternal(deviceHandles, fds, deviceHandlesCount,
+                                        transferSize, transfersCount, uring);
+  }
+  if (result == QUANTIS_ERROR_OPERATION_NOT_SUPPORTED)
+  {
+    result = QuantisUringCreateInternal(deviceHandles, NULL, deviceHandlesCount,
+                                        transferSize, transfersCount, uring);
+  }
+
+  free(fds);
+  return result;
+}
+
+int QuantisUringIsFallback(const QuantisUring *uring)
+{
+  if (!uring)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  return uring->fallback;
+}
+
+int QuantisUringRead(QuantisUring *uring, void *buffer, size_t size)
+{
+  unsigned char *output = (unsigned char *)buffer;
+  size_t copied = 0u;
+  int result;
+
+  if (!uring)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  if (size > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  if (uring->fallback)
+  {
+    /* Reads the devices in turn, by transfers */
+    while (copied < size)
+    {
+      size_t transfer = size - copied;
+      if (transfer > uring->transferSize)
+      {
+        transfer = uring->transferSize;
+      }
+
+      result = QuantisReadHandled(uring->devices[uring->nextDevice].deviceHandle,
+                                  output + copied,
+                                  transfer);
+      if (result < 0)
+      {
+        return result;
+      }
+      copied += (size_t)result;
+      uring->nextDevice = (uring->nextDevice + 1u) % uring->devicesCount;
+    }
+
+    return (int)copied;
+  }
+
+#ifdef QUANTIS_HAVE_IO_URING
+  while (copied < size)
+  {
+    /* Copies out the completed reads first */
+    if (uring->readyCount > 0u)
+    {
+      unsigned int slotIndex = uring->readySlots[uring->readyHead];
+      QuantisUringSlot *slot = &uring->slots[slotIndex];
+      size_t count = slot->length - slot->offset;
+
+      if (count > size - copied)
+      {
+        count = size - copied;
+      }
+      memcpy(output + copied,
+             (unsigned char *)uring->iovecs[slotIndex].iov_base + slot->offset,
+             count);
+      copied += count;
+      slot->offset += count;
+
+      if (slot->offset == slot->length)
+      {
+        uring->readyHead = (uring->readyHead + 1u) % uring->transfersCount;
+        uring->readyCount--;
+        uring->freeSlots[uring->freeCount++] = slotIndex;
+      }
+      continue;
+    }
+
+    if (uring->error < 0)
+    {
+      result = uring->error;
+      uring->error = 0;
+      return result;
+    }
+
+    /* An invalid status only fails the request once nothing is in flight */
+    result = QuantisUringQueueReads(uring);
+    if ((result < 0) && (uring->inFlight == 0u))
+    {
+      return result;
+    }
+
+    result = QuantisUringSubmitAndReap(uring, 1u);
+    if (result < 0)
+    {
+      return result;
+    }
+  }
+
+  /* Keeps the devices busy until the next request */
+  if ((QuantisUringQueueReads(uring) == QUANTIS_SUCCESS) && (uring->toSubmit > 0u))
+  {
+    QuantisUringSubmitAndReap(uring, 0u);
+  }
+
+  return (int)copied;
+#else
+  return QUANTIS_ERROR_OPERATION_NOT_SUPPORTED;
+#endif /* QUANTIS_HAVE_IO_URING */
+}
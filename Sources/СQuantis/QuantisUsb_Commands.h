@@ -92,6 +92,27 @@ DEFINE_GUID(GUID_DEVINTERFACE_QUANTIS_USB,
    */
 #define USB_MAX_BULK_PACKET_SIZE 512
 
+/**
+   * Default size (in bytes) of the asynchronous bulk transfers used to read
+   * random data. Must be a multiple of USB_MAX_BULK_PACKET_SIZE.
+   */
+#define QUANTIS_USB_TRANSFER_SIZE (32 * USB_MAX_BULK_PACKET_SIZE)
+
+/**
+   * Maximal size (in bytes) of an asynchronous bulk transfer.
+   */
+#define QUANTIS_USB_MAX_TRANSFER_SIZE (1024 * 1024)
+
+/**
+   * Default number of asynchronous bulk transfers kept in flight while reading.
+   */
+#define QUANTIS_USB_TRANSFERS_COUNT 8
+
+/**
+   * Maximal number of asynchronous bulk transfers kept in flight while reading.
+   */
+#define QUANTIS_USB_MAX_TRANSFERS_COUNT 64
+
 /**
    * Quantis USB Endpoint for bulk requests.
    * 
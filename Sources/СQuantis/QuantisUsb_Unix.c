@@ -63,6 +63,8 @@
 #include <libusb-1.0/libusb.h>
 #endif
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -78,6 +80,16 @@
 
 /* --------------------- Internal Methods & structures --------------------- */
 
+/**
+ * Asynchronous bulk-IN transfer of the read pipeline
+ */
+typedef struct QuantisUsbTransfer
+{
+  struct libusb_transfer *transfer;
+  unsigned char *buffer;
+  int completed;
+} QuantisUsbTransfer;
+
 /**
  * QuantisDeviceHandlePrivateData for Quantis USB on Unix
  */
@@ -88,8 +100,201 @@ typedef struct QuantisPrivateData
   char serialNumber[255];
   char manufacturer[255];
   unsigned int usbMaxPacketSize;
+
+  /* Read pipeline (allocated on first read) */
+  QuantisUsbTransfer transfers[QUANTIS_USB_MAX_TRANSFERS_COUNT];
+  unsigned int transfersCount;
+  size_t transferSize;
+
+  /* Unused tail of the last packet, served first by next read */
+  unsigned char residual[USB_MAX_BULK_PACKET_SIZE];
+  size_t residualOffset;
+  size_t residualLength;
 } QuantisPrivateData;
 
+/*
+ * libusb context shared by all Quantis USB handles, and list of the Quantis
+ * USB devices attached to the system.
+ *
+ * The context lives as long as a handle (or a QuantisUsbCount call) uses it.
+ * The device list is scanned again when libusb reports a Quantis USB being
+ * plugged or unplugged, or on QuantisUsbRescan when hotplug is not supported.
+ */
+static pthread_mutex_t usbSharedLock = PTHREAD_MUTEX_INITIALIZER;
+static libusb_context *usbSharedContext = NULL;
+static unsigned int usbSharedReferences = 0u;
+static int usbHotplugRegistered = 0;
+static libusb_hotplug_callback_handle usbHotplugHandle;
+static libusb_device *usbDevices[MAX_QUANTIS_DEVICE];
+static int usbDevicesCount = 0;
+static atomic_int usbDevicesStale = 1;
+
+static int LIBUSB_CALL QuantisUsbHotplugCallback(libusb_context *libusbContext,
+                                                 libusb_device *dev,
+                                                 libusb_hotplug_event event,
+                                                 void *userData)
+{
+  libusbContext = libusbContext; /* Avoids unused parameter warning */
+  dev = dev; /* Avoids unused parameter warning */
+  event = event; /* Avoids unused parameter warning */
+  userData = userData; /* Avoids unused parameter warning */
+
+  /* Devices list will be scanned again on next use */
+  atomic_store(&usbDevicesStale, 1);
+
+  /* Keeps the callback registered */
+  return 0;
+}
+
+/* Unreferences the devices of the devices list. usbSharedLock must be held */
+static void QuantisUsbFreeDevices()
+{
+  int i;
+
+  for (i = 0; i < usbDevicesCount; i++)
+  {
+    libusb_unref_device(usbDevices[i]);
+    usbDevices[i] = NULL;
+  }
+  usbDevicesCount = 0;
+  atomic_store(&usbDevicesStale, 1);
+}
+
+/* Fills the devices list with Quantis USB devices. usbSharedLock must be held */
+static int QuantisUsbScanDevices()
+{
+  libusb_device *dev = NULL;
+  libusb_device **systemDevices = NULL;
+  int result = QUANTIS_SUCCESS;
+  int i = 0;
+
+  QuantisUsbFreeDevices();
+
+  /* Cleared before the scan, so a device plugged meanwhile triggers a new one */
+  atomic_store(&usbDevicesStale, 0);
+
+  /* Returns a list of USB devices currently attached to the system */
+  if (libusb_get_device_list(usbSharedContext, &systemDevices) < 0)
+  {
+    atomic_store(&usbDevicesStale, 1);
+    return QUANTIS_ERROR_IO;
+  }
+
+  /* Search Quantis USB devices */
+  while (((dev = systemDevices[i++]) != NULL) && (usbDevicesCount < MAX_QUANTIS_DEVICE))
+  {
+    struct libusb_device_descriptor desc;
+    memset(&desc, 0, sizeof(desc));
+
+    if (libusb_get_device_descriptor(dev, &desc) < 0)
+    {
+      QuantisUsbFreeDevices();
+      result = QUANTIS_ERROR_IO;
+      break;
+    }
+
+    if ((desc.idVendor == VENDOR_ID_ELLISYS) &&
+        (desc.idProduct == DEVICE_ID_QUANTIS_USB))
+    {
+      usbDevices[usbDevicesCount++] = libusb_ref_device(dev);
+    }
+  }
+
+  libusb_free_device_list(systemDevices, 1);
+
+  return result;
+}
+
+/* Refreshes the devices list if needed. usbSharedLock must be held */
+static int QuantisUsbRefreshDevices()
+{
+  struct timeval noTimeout = {0, 0};
+
+  if (usbHotplugRegistered)
+  {
+    /* Runs pending hotplug callbacks */
+    libusb_handle_events_timeout_completed(usbSharedContext, &noTimeout, NULL);
+  }
+
+  if (atomic_load(&usbDevicesStale))
+  {
+    return QuantisUsbScanDevices();
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Gets a reference on the shared libusb context, initializing it if needed */
+static int QuantisUsbAcquireContext(libusb_context **libusbContext)
+{
+  int result = QUANTIS_SUCCESS;
+
+  pthread_mutex_lock(&usbSharedLock);
+
+  if (usbSharedReferences == 0u)
+  {
+    /* Initialize libusb */
+    if (libusb_init(&usbSharedContext) != LIBUSB_SUCCESS)
+    {
+      usbSharedContext = NULL;
+      result = QUANTIS_ERROR_IO;
+      goto unlock;
+    }
+
+    /* Disable libusb messages */
+    libusb_set_debug(usbSharedContext, 0);
+
+    /* Keeps the devices list up to date when the platform allows it */
+    usbHotplugRegistered = 0;
+    if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG) &&
+        (libusb_hotplug_register_callback(usbSharedContext,
+                                          LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED |
+                                              LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+                                          LIBUSB_HOTPLUG_NO_FLAGS,
+                                          VENDOR_ID_ELLISYS,
+                                          DEVICE_ID_QUANTIS_USB,
+                                          LIBUSB_HOTPLUG_MATCH_ANY,
+                                          QuantisUsbHotplugCallback,
+                                          NULL,
+                                          &usbHotplugHandle) == LIBUSB_SUCCESS))
+    {
+      usbHotplugRegistered = 1;
+    }
+
+    atomic_store(&usbDevicesStale, 1);
+  }
+
+  usbSharedReferences++;
+  *libusbContext = usbSharedContext;
+
+unlock:
+  pthread_mutex_unlock(&usbSharedLock);
+
+  return result;
+}
+
+/* Releases a reference on the shared libusb context */
+static void QuantisUsbReleaseContext()
+{
+  pthread_mutex_lock(&usbSharedLock);
+
+  usbSharedReferences--;
+  if (usbSharedReferences == 0u)
+  {
+    if (usbHotplugRegistered)
+    {
+      libusb_hotplug_deregister_callback(usbSharedContext, usbHotplugHandle);
+      usbHotplugRegistered = 0;
+    }
+
+    QuantisUsbFreeDevices();
+    libusb_exit(usbSharedContext);
+    usbSharedContext = NULL;
+  }
+
+  pthread_mutex_unlock(&usbSharedLock);
+}
+
 static int QuantisUsbGetIntValue(QuantisDeviceHandle *deviceHandle, char request)
 {
   QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
@@ -176,6 +381,239 @@ static int QuantisUsbSendRequest(QuantisDeviceHandle *deviceHandle, char request
   return QUANTIS_SUCCESS;
 }
 
+static void LIBUSB_CALL QuantisUsbTransferCallback(struct libusb_transfer *transfer)
+{
+  QuantisUsbTransfer *usbTransfer = (QuantisUsbTransfer *)transfer->user_data;
+  usbTransfer->completed = 1;
+}
+
+static void QuantisUsbFreeTransfers(QuantisPrivateData *_privateData)
+{
+  unsigned int i;
+
+  for (i = 0; i < QUANTIS_USB_MAX_TRANSFERS_COUNT; i++)
+  {
+    if (_privateData->transfers[i].transfer)
+    {
+      libusb_free_transfer(_privateData->transfers[i].transfer);
+    }
+    _privateData->transfers[i].transfer = NULL;
+    _privateData->transfers[i].buffer = NULL;
+  }
+}
+
+static int QuantisUsbAllocTransfers(QuantisPrivateData *_privateData)
+{
+  unsigned int i;
+
+  for (i = 0; i < _privateData->transfersCount; i++)
+  {
+    _privateData->transfers[i].transfer = libusb_alloc_transfer(0);
+    if (!_privateData->transfers[i].transfer)
+    {
+      QuantisUsbFreeTransfers(_privateData);
+      return QUANTIS_ERROR_NO_MEMORY;
+    }
+    _privateData->transfers[i].completed = 1;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/*
+ * Submits a bulk-IN transfer of size bytes directly into buffer.
+ *
+ * NOTE: size MUST be a multiple of usbMaxPacketSize, otherwise the request fails...
+ */
+static int QuantisUsbSubmitTransfer(QuantisPrivateData *_privateData,
+                                    QuantisUsbTransfer *usbTransfer,
+                                    unsigned char *buffer,
+                                    size_t size)
+{
+  int result;
+
+  usbTransfer->buffer = buffer;
+  libusb_fill_bulk_transfer(usbTransfer->transfer,
+                            _privateData->libusbDeviceHandle,
+                            QUANTIS_USB_ENDPOINT_BULK_IN,
+                            buffer,
+                            (int)size,
+                            QuantisUsbTransferCallback,
+                            usbTransfer,
+                            QUANTIS_USB_REQUEST_TIMEOUT);
+
+  usbTransfer->completed = 0;
+  result = libusb_submit_transfer(usbTransfer->transfer);
+  if (result != LIBUSB_SUCCESS)
+  {
+    usbTransfer->completed = 1;
+    return result;
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+/* Handles libusb events until the transfer is completed */
+static void QuantisUsbWaitTransfer(QuantisPrivateData *_privateData,
+                                   QuantisUsbTransfer *usbTransfer)
+{
+  struct timeval timeout;
+
+  /* Transfers have their own timeout, so this loop always ends */
+  while (!usbTransfer->completed)
+  {
+    timeout.tv_sec = QUANTIS_USB_REQUEST_TIMEOUT / 1000;
+    timeout.tv_usec = (QUANTIS_USB_REQUEST_TIMEOUT % 1000) * 1000;
+    libusb_handle_events_timeout_completed(_privateData->libusbContext,
+                                           &timeout,
+                                           &usbTransfer->completed);
+  }
+}
+
+/* Returns the result of a completed transfer, like libusb_bulk_transfer does */
+static int QuantisUsbTransferResult(QuantisUsbTransfer *usbTransfer)
+{
+  switch (usbTransfer->transfer->status)
+  {
+  case LIBUSB_TRANSFER_COMPLETED:
+    if (usbTransfer->transfer->actual_length != usbTransfer->transfer->length)
+    {
+      return QUANTIS_ERROR_IO;
+    }
+    return QUANTIS_SUCCESS;
+
+  case LIBUSB_TRANSFER_TIMED_OUT:
+    return LIBUSB_ERROR_TIMEOUT;
+
+  case LIBUSB_TRANSFER_STALL:
+    return LIBUSB_ERROR_PIPE;
+
+  case LIBUSB_TRANSFER_NO_DEVICE:
+    return LIBUSB_ERROR_NO_DEVICE;
+
+  case LIBUSB_TRANSFER_OVERFLOW:
+    return LIBUSB_ERROR_OVERFLOW;
+
+  default:
+    return LIBUSB_ERROR_IO;
+  }
+}
+
+/* Cancels the transfers in flight and waits until libusb gives them back */
+static void QuantisUsbCancelTransfers(QuantisPrivateData *_privateData,
+                                      unsigned int head,
+                                      unsigned int inFlight)
+{
+  unsigned int i;
+
+  for (i = 0; i < inFlight; i++)
+  {
+    libusb_cancel_transfer(_privateData->transfers[(head + i) % _privateData->transfersCount].transfer);
+  }
+
+  for (i = 0; i < inFlight; i++)
+  {
+    QuantisUsbWaitTransfer(_privateData,
+                           &_privateData->transfers[(head + i) % _privateData->transfersCount]);
+  }
+}
+
+/* Copies up to size bytes of the residual packet to buffer */
+static size_t QuantisUsbTakeResidual(QuantisPrivateData *_privateData,
+                                     void *buffer,
+                                     size_t size)
+{
+  size_t available = _privateData->residualLength - _privateData->residualOffset;
+  if (size > available)
+  {
+    size = available;
+  }
+
+  memcpy(buffer, _privateData->residual + _privateData->residualOffset, size);
+  _privateData->residualOffset += size;
+
+  return size;
+}
+
+/*
+ * Reads size bytes (a multiple of usbMaxPacketSize) into buffer, keeping up
+ * to transfersCount transfers in flight.
+ */
+static int QuantisUsbReadPackets(QuantisDeviceHandle *deviceHandle,
+                                 unsigned char *buffer,
+                                 size_t size)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  QuantisUsbTransfer *usbTransfer = NULL;
+  size_t requestedBytes = 0u; /* Bytes covered by submitted transfers */
+  size_t readBytes = 0u;      /* Bytes received */
+  unsigned int head = 0u;     /* Oldest transfer in flight */
+  unsigned int inFlight = 0u;
+  int result = 0;
+
+  if (!_privateData->transfers[0].transfer)
+  {
+    result = QuantisUsbAllocTransfers(_privateData);
+    if (result < 0)
+    {
+      return result;
+    }
+  }
+
+  while (readBytes < size)
+  {
+    /* Keeps up to transfersCount transfers in flight */
+    while ((inFlight < _privateData->transfersCount) && (requestedBytes < size))
+    {
+      size_t chunkSize = size - requestedBytes;
+      if (chunkSize > _privateData->transferSize)
+      {
+        chunkSize = _privateData->transferSize;
+      }
+
+      /* Check if the status of the module is ok */
+      result = QuantisCheckStatusInternal(deviceHandle, chunkSize);
+      if (result < 0)
+      {
+        goto cancel;
+      }
+
+      usbTransfer = &_privateData->transfers[(head + inFlight) % _privateData->transfersCount];
+      result = QuantisUsbSubmitTransfer(_privateData,
+                                        usbTransfer,
+                                        buffer + requestedBytes,
+                                        chunkSize);
+      if (result < 0)
+      {
+        goto cancel;
+      }
+
+      requestedBytes += chunkSize;
+      inFlight++;
+    }
+
+    /* Bulk transfers complete in submission order: waits for the oldest one */
+    usbTransfer = &_privateData->transfers[head];
+    QuantisUsbWaitTransfer(_privateData, usbTransfer);
+    head = (head + 1) % _privateData->transfersCount;
+    inFlight--;
+
+    result = QuantisUsbTransferResult(usbTransfer);
+    if (result < 0)
+    {
+      goto cancel;
+    }
+
+    readBytes += usbTransfer->transfer->actual_length;
+  }
+
+  return QUANTIS_SUCCESS;
+
+cancel:
+  QuantisUsbCancelTransfers(_privateData, head, inFlight);
+  return result;
+}
+
 /* --------------------------- QuantisUsb Methods --------------------------- */
 
 /* Board reset */
@@ -204,9 +642,11 @@ void QuantisUsbClose(QuantisDeviceHandle *deviceHandle)
     return;
   }
 
+  QuantisUsbFreeTransfers(_privateData);
+
   libusb_release_interface(_privateData->libusbDeviceHandle, 0);
   libusb_close(_privateData->libusbDeviceHandle);
-  libusb_exit(_privateData->libusbContext);
+  QuantisUsbReleaseContext();
 
   free(_privateData);
   _privateData = NULL;
@@ -215,55 +655,22 @@ void QuantisUsbClose(QuantisDeviceHandle *deviceHandle)
 /* Count */
 int QuantisUsbCount()
 {
-  int result = 0;
-  libusb_device *dev = NULL;
-  libusb_device **usbDevices = NULL;
   libusb_context *libusbContext = NULL;
-  int quantisUsbCount = 0;
-  int i = 0;
-
-  /* Initialize libusb */
-  result = libusb_init(&libusbContext);
-  if (result != LIBUSB_SUCCESS)
+  int result = QuantisUsbAcquireContext(&libusbContext);
+  if (result < 0)
   {
-    result = QUANTIS_ERROR_IO;
-    goto cleanupContext;
+    return result;
   }
 
-  /* Returns a list of USB devices currently attached to the system */
-  if (libusb_get_device_list(libusbContext, &usbDevices) < 0)
+  pthread_mutex_lock(&usbSharedLock);
+  result = QuantisUsbRefreshDevices();
+  if (result == QUANTIS_SUCCESS)
   {
-    result = QUANTIS_ERROR_IO;
-    goto cleanup;
+    result = usbDevicesCount;
   }
+  pthread_mutex_unlock(&usbSharedLock);
 
-  /* Search Quantis USB devices */
-  while ((dev = usbDevices[i++]) != NULL)
-  {
-    struct libusb_device_descriptor desc;
-    memset(&desc, 0, sizeof(desc));
-
-    result = libusb_get_device_descriptor(dev, &desc);
-    if (result < 0)
-    {
-      result = QUANTIS_ERROR_IO;
-      goto cleanup;
-    }
-
-    if ((desc.idVendor == VENDOR_ID_ELLISYS) &&
-        (desc.idProduct == DEVICE_ID_QUANTIS_USB))
-    {
-      quantisUsbCount++;
-    }
-  }
-
-  result = quantisUsbCount;
-
-cleanup:
-  libusb_free_device_list(usbDevices, 1);
-
-cleanupContext:
-  libusb_exit(libusbContext);
+  QuantisUsbReleaseContext();
 
   return result;
 }
@@ -372,11 +779,8 @@ int QuantisUsbClearAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandl
 /* Open */
 int QuantisUsbOpen(QuantisDeviceHandle *deviceHandle)
 {
-  ssize_t usbDevicesCount = 0;
   int result = 0;
   libusb_device *dev = NULL;
-  libusb_device **usbDevices = NULL;
-  libusb_device **quantisUsbDevices = NULL;
   libusb_device_handle *libusbDeviceHandle = NULL;
   libusb_context *libusbContext = NULL;
   struct libusb_device_descriptor desc;
@@ -385,65 +789,33 @@ int QuantisUsbOpen(QuantisDeviceHandle *deviceHandle)
   struct libusb_interface_descriptor usbInterfaceDescriptor;
 
   QuantisPrivateData *_privateData = NULL;
-  int quantisUsbCount = 0;
-  int i = 0;
 
-  /* Initialize libusb */
-  result = libusb_init(&libusbContext);
-  if (result != LIBUSB_SUCCESS)
+  /* Get the shared libusb context */
+  result = QuantisUsbAcquireContext(&libusbContext);
+  if (result < 0)
   {
-    result = QUANTIS_ERROR_IO;
-    goto cleanupContext;
+    return result;
   }
 
-  /* Disable libusb messages */
-  libusb_set_debug(libusbContext, 0);
-
-  /* Allocate memory for Quantis USB devices */
-  quantisUsbDevices = malloc(sizeof(void *) * (MAX_QUANTIS_DEVICE + 1));
-  if (!quantisUsbDevices)
+  /* Select Quantis USB */
+  pthread_mutex_lock(&usbSharedLock);
+  result = QuantisUsbRefreshDevices();
+  if ((result == QUANTIS_SUCCESS) && (deviceHandle->deviceNumber < usbDevicesCount))
   {
-    result = QUANTIS_ERROR_NO_MEMORY;
-    goto cleanupContext;
+    dev = libusb_ref_device(usbDevices[deviceHandle->deviceNumber]);
   }
-  quantisUsbDevices[MAX_QUANTIS_DEVICE] = NULL;
+  pthread_mutex_unlock(&usbSharedLock);
 
-  /* Returns a list of USB devices currently attached to the system */
-  usbDevicesCount = libusb_get_device_list(libusbContext, &usbDevices);
-  if (usbDevicesCount < 0)
+  if (result < 0)
   {
-    result = QUANTIS_ERROR_IO;
     goto cleanup;
   }
-
-  /* Search Quantis USB devices */
-  i = 0;
-  while ((dev = usbDevices[i++]) != NULL)
-  {
-    result = libusb_get_device_descriptor(dev, &desc);
-    if (result != LIBUSB_SUCCESS)
-    {
-      result = QUANTIS_ERROR_IO;
-      goto cleanup;
-    }
-
-    if ((desc.idVendor == VENDOR_ID_ELLISYS) &&
-        (desc.idProduct == DEVICE_ID_QUANTIS_USB))
-    {
-      quantisUsbDevices[quantisUsbCount] = dev;
-      quantisUsbCount++;
-    }
-  }
-
-  /* Select Quantis USB */
-  if ((quantisUsbCount == 0) || (quantisUsbCount < deviceHandle->deviceNumber))
+  else if (!dev)
   {
     result = QUANTIS_ERROR_NO_DEVICE;
     goto cleanup;
   }
 
-  dev = quantisUsbDevices[deviceHandle->deviceNumber];
-
   /* Load descriptor for selected device */
   result = libusb_get_device_descriptor(dev, &desc);
   if (result != LIBUSB_SUCCESS)
@@ -485,8 +857,11 @@ int QuantisUsbOpen(QuantisDeviceHandle *deviceHandle)
   }
 
   /* Set private data */
+  memset(_privateData, 0, sizeof(QuantisPrivateData));
   _privateData->libusbContext = libusbContext;
   _privateData->libusbDeviceHandle = libusbDeviceHandle;
+  _privateData->transfersCount = QUANTIS_USB_TRANSFERS_COUNT;
+  _privateData->transferSize = QUANTIS_USB_TRANSFER_SIZE;
 
   /* Determine maximum packet size */
   result = libusb_get_config_descriptor(dev, 0, &usbConfig);
@@ -517,8 +892,16 @@ int QuantisUsbOpen(QuantisDeviceHandle *deviceHandle)
   }
 
   _privateData->usbMaxPacketSize = usbInterfaceDescriptor.endpoint[0].wMaxPacketSize;
+  if ((_privateData->usbMaxPacketSize == 0) ||
+      (_privateData->usbMaxPacketSize > USB_MAX_BULK_PACKET_SIZE))
+  {
+    /* The residual packet buffer could not hold a packet */
+    result = QUANTIS_ERROR_IO;
+    goto cleanup;
+  }
 
   libusb_free_config_descriptor(usbConfig);
+  usbConfig = NULL;
 
   /* Get serial number */
   result = libusb_get_string_descriptor_ascii(libusbDeviceHandle,
@@ -548,14 +931,31 @@ int QuantisUsbOpen(QuantisDeviceHandle *deviceHandle)
 
   deviceHandle->privateData = _privateData;
 
-  result = QUANTIS_SUCCESS;
+  libusb_unref_device(dev);
+
+  return QUANTIS_SUCCESS;
 
   /* Cleanup */
 cleanup:
-  free(quantisUsbDevices);
+  if (usbConfig)
+  {
+    libusb_free_config_descriptor(usbConfig);
+  }
 
-cleanupContext:
-  libusb_free_device_list(usbDevices, 1);
+  free(_privateData);
+
+  if (libusbDeviceHandle)
+  {
+    libusb_release_interface(libusbDeviceHandle, 0);
+    libusb_close(libusbDeviceHandle);
+  }
+
+  if (dev)
+  {
+    libusb_unref_device(dev);
+  }
+
+  QuantisUsbReleaseContext();
 
   return result;
 }
@@ -564,48 +964,100 @@ cleanupContext:
 int QuantisUsbRead(QuantisDeviceHandle *deviceHandle, void *buffer, size_t size)
 {
   QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
-  unsigned char tempBuffer[USB_MAX_BULK_PACKET_SIZE];
+  size_t packetSize = _privateData->usbMaxPacketSize;
+  size_t readBytes = 0u;
+  size_t directBytes = 0u;
   int result = 0;
-  int readBytes = 0;
-  int transferred = 0;
 
-  while (readBytes < (int)size)
-  {
-    size_t chunkSize = size - readBytes;
-    if (chunkSize > _privateData->usbMaxPacketSize)
-    {
-      chunkSize = _privateData->usbMaxPacketSize;
-    }
+  /* Serves the tail of the last packet first */
+  readBytes = QuantisUsbTakeResidual(_privateData, buffer, size);
 
-    /* Check if the status of the module is ok */
-    if (QuantisUsbGetModulesStatus(deviceHandle) <= 0)
+  /* Full packets are transferred straight into user's buffer */
+  directBytes = ((size - readBytes) / packetSize) * packetSize;
+  if (directBytes > 0u)
+  {
+    result = QuantisUsbReadPackets(deviceHandle,
+                                   (unsigned char *)buffer + readBytes,
+                                   directBytes);
+    if (result < 0)
     {
-      return QUANTIS_ERROR_INVALID_STATUS;
+      return result;
     }
+    readBytes += directBytes;
+  }
 
-    /*
-     * Read data
-     *
-     * NOTE: we MUST request usbMaxPacketSize data, otherwise the request fails...
-     */
-    result = libusb_bulk_transfer(_privateData->libusbDeviceHandle,
-                                  QUANTIS_USB_ENDPOINT_BULK_IN,
-                                  tempBuffer,
-                                  _privateData->usbMaxPacketSize,
-                                  &transferred,
-                                  QUANTIS_USB_REQUEST_TIMEOUT);
-    if ((result < 0) || (transferred != (int)_privateData->usbMaxPacketSize))
+  /* Reads one more packet, its unused tail is kept for next read */
+  if (readBytes < size)
+  {
+    result = QuantisUsbReadPackets(deviceHandle, _privateData->residual, packetSize);
+    if (result < 0)
     {
       return result;
     }
+    _privateData->residualOffset = 0u;
+    _privateData->residualLength = packetSize;
 
-    /* Copy data to user's buffer */
-    memcpy((char *)buffer + readBytes, (char *)tempBuffer, chunkSize);
+    readBytes += QuantisUsbTakeResidual(_privateData,
+                                        (unsigned char *)buffer + readBytes,
+                                        size - readBytes);
+  }
 
-    readBytes += chunkSize;
+  return (int)readBytes;
+}
+
+/* Rescan */
+int QuantisUsbRescan()
+{
+  libusb_context *libusbContext = NULL;
+  int result = QuantisUsbAcquireContext(&libusbContext);
+  if (result < 0)
+  {
+    return result;
   }
 
-  return readBytes;
+  pthread_mutex_lock(&usbSharedLock);
+  result = QuantisUsbScanDevices();
+  if (result == QUANTIS_SUCCESS)
+  {
+    result = usbDevicesCount;
+  }
+  pthread_mutex_unlock(&usbSharedLock);
+
+  QuantisUsbReleaseContext();
+
+  return result;
+}
+
+/* SetReadPipeline */
+int QuantisUsbSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                              size_t transferSize,
+                              unsigned int transfersCount)
+{
+  QuantisPrivateData *_privateData = (QuantisPrivateData *)deviceHandle->privateData;
+  size_t packetSize = _privateData->usbMaxPacketSize;
+
+  if (transferSize == 0u)
+  {
+    transferSize = QUANTIS_USB_TRANSFER_SIZE;
+  }
+
+  if (transfersCount == 0u)
+  {
+    transfersCount = QUANTIS_USB_TRANSFERS_COUNT;
+  }
+
+  if ((transferSize > QUANTIS_USB_MAX_TRANSFER_SIZE) ||
+      (transfersCount > QUANTIS_USB_MAX_TRANSFERS_COUNT))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* Transfers are allocated again on next read */
+  QuantisUsbFreeTransfers(_privateData);
+  _privateData->transferSize = ((transferSize + packetSize - 1) / packetSize) * packetSize;
+  _privateData->transfersCount = transfersCount;
+
+  return QUANTIS_SUCCESS;
 }
 
 #pragma GCC diagnostic ignored "-Wunused-parameter"
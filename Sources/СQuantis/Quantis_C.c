@@ -48,23 +48,89 @@
  * For history of changes, see ChangeLog.txt
  */
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "Conversion.h"
 #include "Quantis.h"
 #include "Quantis_Internal.h"
 
-/* Internal variable to store serial number */
-char serialNumber[256];
+/* Internal variable to store serial number (per thread, calls may run concurrently) */
+static _Thread_local char serialNumber[QUANTIS_DEVICE_INFO_STRING_LENGTH];
 
 /* Internal variable to store manufactuer's name */
-char manufactuer[256];
+static _Thread_local char manufactuer[QUANTIS_DEVICE_INFO_STRING_LENGTH];
+
+/* Copies a string returned by a device into a buffer of QUANTIS_DEVICE_INFO_STRING_LENGTH bytes */
+static void QuantisCopyDeviceString(char *destination, const char *source)
+{
+  size_t length = strlen(source);
+  if (length >= QUANTIS_DEVICE_INFO_STRING_LENGTH)
+  {
+    length = QUANTIS_DEVICE_INFO_STRING_LENGTH - 1u;
+  }
+  memcpy(destination, source, length);
+  destination[length] = '\0';
+}
 
 /* Size of the buffer used for QuantisReadXXX methods */
 #define QUANTIS_READ_XXX_BUFFER_SIZE 8
 
+/* Number of device types whose handles can be cached (see QuantisCacheSlot) */
+#define QUANTIS_CACHE_DEVICE_TYPES 3
+
+/**
+ * Entry of the handle cache. The lock of an entry is held for the whole
+ * duration of a request, so a cached handle is never used by two threads at
+ * the same time.
+ */
+typedef struct QuantisCacheEntry
+{
+  pthread_mutex_t lock;
+  QuantisDeviceHandle *deviceHandle;
+  /* Size of the prefetch buffer of the handle, 0 when prefetch is disabled */
+  size_t prefetchSize;
+} QuantisCacheEntry;
+
+/* Internal cache of opened handles, indexed by device type and number */
+static QuantisCacheEntry *handleCache[QUANTIS_CACHE_DEVICE_TYPES][MAX_QUANTIS_DEVICE];
+
+/* Protects handleCache itself (entries are protected by their own lock) */
+static pthread_mutex_t handleCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * State of the status check of a handle (see QuantisSetStatusCheck).
+ * A handle without monitor is in QUANTIS_STATUS_CHECK_STRICT mode.
+ */
+struct QuantisStatusMonitor
+{
+  QuantisStatusCheckMode mode;
+  unsigned int interval;
+
+  /* Last known modules status, also written by the background thread */
+  atomic_int status;
+
+  /* Time (in ms) of the last check and number of bytes read since */
+  uint64_t lastCheck;
+  size_t uncheckedBytes;
+
+  /* Background thread */
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int running;
+};
+
+/* Status check mode of newly opened handles */
+static QuantisStatusCheckMode defaultStatusCheckMode = QUANTIS_STATUS_CHECK_STRICT;
+static unsigned int defaultStatusCheckInterval = 0u;
+
 #ifndef DISABLE_QUANTIS_PCI
 QuantisOperations QuantisOperationsPci =
     {
@@ -86,7 +152,9 @@ QuantisOperations QuantisOperationsPci =
         /*.GetBusDeviceId = */ QuantisPciGetBusDeviceId,
         /*.QuantisTypeStrError = */ QuantisPciTypeStrError,
         /*.GetAis31StartupTestsRequestFlag*/ QuantisPciGetAis31StartupTestsRequestFlag,
-        /*.ClearAis31StartupTestsRequestFlag*/ QuantisPciClearAis31StartupTestsRequestFlag};
+        /*.ClearAis31StartupTestsRequestFlag*/ QuantisPciClearAis31StartupTestsRequestFlag,
+        /*.SetReadPipeline = */ QuantisPciSetReadPipeline,
+        /*.Rescan = */ QuantisPciRescan};
 #endif /* DISABLE_QUANTIS_PCI */
 
 #ifndef DISABLE_QUANTIS_USB
@@ -110,33 +178,370 @@ QuantisOperations QuantisOperationsUsb =
         /*.GetBusDeviceId = */ QuantisUsbGetBusDeviceId,
         /*.QuantisTypeStrError = */ QuantisUsbTypeStrError,
         /*.GetAis31StartupTestsRequestFlag*/ QuantisUsbGetAis31StartupTestsRequestFlag,
-        /*.ClearAis31StartupTestsRequestFlag*/ QuantisUsbClearAis31StartupTestsRequestFlag
+        /*.ClearAis31StartupTestsRequestFlag*/ QuantisUsbClearAis31StartupTestsRequestFlag,
+        /*.SetReadPipeline = */ QuantisUsbSetReadPipeline,
+        /*.Rescan = */ QuantisUsbRescan
 
 };
 #endif /* DISABLE_QUANTIS_USB */
 
+#ifndef DISABLE_QUANTIS_SIM
+QuantisOperations QuantisOperationsSim =
+    {
+        /*.BoardReset = */ QuantisSimBoardReset,
+        /*.Close = */ QuantisSimClose,
+        /*.Count = */ QuantisSimCount,
+        /*.GetBoardVersion = */ QuantisSimGetBoardVersion,
+        /*.GetDriverVersion = */ QuantisSimGetDriverVersion,
+        /*.GetManufacturer = */ QuantisSimGetManufacturer,
+        /*.GetModulesMask = */ QuantisSimGetModulesMask,
+        /*.GetModulesDataRate = */ QuantisSimGetModulesDataRate,
+        /*.GetModulesPower = */ QuantisSimGetModulesPower,
+        /*.GetModulesStatus = */ QuantisSimGetModulesStatus,
+        /*.GetSerialNumber = */ QuantisSimGetSerialNumber,
+        /*.ModulesDisable = */ QuantisSimModulesDisable,
+        /*.ModulesEnable = */ QuantisSimModulesEnable,
+        /*.Open = */ QuantisSimOpen,
+        /*.Read = */ QuantisSimRead,
+        /*.GetBusDeviceId = */ QuantisSimGetBusDeviceId,
+        /*.QuantisTypeStrError = */ QuantisSimTypeStrError,
+        /*.GetAis31StartupTestsRequestFlag*/ QuantisSimGetAis31StartupTestsRequestFlag,
+        /*.ClearAis31StartupTestsRequestFlag*/ QuantisSimClearAis31StartupTestsRequestFlag,
+        /*.SetReadPipeline = */ QuantisSimSetReadPipeline,
+        /*.Rescan = */ QuantisSimRescan};
+#endif /* DISABLE_QUANTIS_SIM */
+
+/* Returns the index of deviceType in handleCache or -1 if not cacheable */
+static int QuantisCacheSlot(QuantisDeviceType deviceType)
+{
+  switch (deviceType)
+  {
+  case QUANTIS_DEVICE_PCI:
+    return 0;
+
+  case QUANTIS_DEVICE_USB:
+    return 1;
+
+  case QUANTIS_DEVICE_SIM:
+    return 2;
+
+  default:
+    return -1;
+  }
+}
+
+/* Returns the cache entry of a device, optionally creating it */
+static QuantisCacheEntry *QuantisCacheGetEntry(QuantisDeviceType deviceType,
+                                               unsigned int deviceNumber,
+                                               int create)
+{
+  QuantisCacheEntry *entry = NULL;
+  int slot = QuantisCacheSlot(deviceType);
+
+  if ((slot < 0) || (deviceNumber >= MAX_QUANTIS_DEVICE))
+  {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&handleCacheLock);
+  entry = handleCache[slot][deviceNumber];
+  if (!entry && create)
+  {
+    entry = (QuantisCacheEntry *)malloc(sizeof(QuantisCacheEntry));
+    if (entry)
+    {
+      pthread_mutex_init(&entry->lock, NULL);
+      entry->deviceHandle = NULL;
+      entry->prefetchSize = 0u;
+      handleCache[slot][deviceNumber] = entry;
+    }
+  }
+  pthread_mutex_unlock(&handleCacheLock);
+
+  return entry;
+}
+
+/*
+ * Returns 1 when result reports a failure of the device itself (and not of
+ * the request), meaning the handle can no longer be trusted.
+ */
+static int QuantisIsHandleError(int result)
+{
+  switch (result)
+  {
+  case QUANTIS_ERROR_INVALID_PARAMETER:
+  case QUANTIS_ERROR_INVALID_READ_SIZE:
+  case QUANTIS_ERROR_INVALID_STATUS:
+  case QUANTIS_ERROR_NO_MODULE:
+  case QUANTIS_ERROR_OPERATION_NOT_SUPPORTED:
+    return 0;
+
+  default:
+    return (result < 0);
+  }
+}
+
+int QuantisAcquireInternal(QuantisDeviceType deviceType,
+                           unsigned int deviceNumber,
+                           QuantisDeviceHandle **deviceHandle)
+{
+  QuantisCacheEntry *entry = NULL;
+  int result;
+
+  /* Consistency checks */
+  if (deviceNumber >= MAX_QUANTIS_DEVICE)
+  {
+    return QUANTIS_ERROR_INVALID_DEVICE_NUMBER;
+  }
+
+  if (QuantisCacheSlot(deviceType) < 0)
+  {
+    return QUANTIS_ERROR_NO_DEVICE;
+  }
+
+  entry = QuantisCacheGetEntry(deviceType, deviceNumber, 1);
+  if (!entry)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  /* The entry stays locked until QuantisReleaseInternal */
+  pthread_mutex_lock(&entry->lock);
+
+  if (!entry->deviceHandle)
+  {
+    result = QuantisOpenInternal(deviceType, deviceNumber, &entry->deviceHandle);
+    if ((result >= 0) && (entry->prefetchSize > 0u))
+    {
+      result = QuantisStartPrefetch(entry->deviceHandle, entry->prefetchSize);
+      if (result < 0)
+      {
+        QuantisCloseInternal(entry->deviceHandle);
+      }
+    }
+
+    if (result < 0)
+    {
+      entry->deviceHandle = NULL;
+      pthread_mutex_unlock(&entry->lock);
+      return result;
+    }
+  }
+
+  *deviceHandle = entry->deviceHandle;
+
+  return QUANTIS_SUCCESS;
+}
+
 int QuantisBoardReset(QuantisDeviceType deviceType,
                       unsigned int deviceNumber)
 {
   int result;
+  size_t prefetchSize;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
   }
 
+  /* Prefetched data was generated before the reset: drop it */
+  prefetchSize = QuantisPrefetchGetSize(deviceHandle);
+  QuantisStopPrefetch(deviceHandle);
+
   /* Perform request */
   result = deviceHandle->ops->BoardReset(deviceHandle);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  if ((result >= 0) && (prefetchSize > 0u))
+  {
+    result = QuantisStartPrefetch(deviceHandle, prefetchSize);
+  }
+
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
 
+void QuantisCacheEvict(QuantisDeviceType deviceType,
+                       unsigned int deviceNumber)
+{
+  QuantisCacheEntry *entry = QuantisCacheGetEntry(deviceType, deviceNumber, 0);
+  if (!entry)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&entry->lock);
+  QuantisCloseInternal(entry->deviceHandle);
+  entry->deviceHandle = NULL;
+  pthread_mutex_unlock(&entry->lock);
+}
+
+void QuantisCacheEvictAll()
+{
+  unsigned int deviceNumber;
+
+#ifndef DISABLE_QUANTIS_PCI
+  for (deviceNumber = 0; deviceNumber < MAX_QUANTIS_DEVICE; deviceNumber++)
+  {
+    QuantisCacheEvict(QUANTIS_DEVICE_PCI, deviceNumber);
+  }
+#endif /* DISABLE_QUANTIS_PCI */
+
+#ifndef DISABLE_QUANTIS_USB
+  for (deviceNumber = 0; deviceNumber < MAX_QUANTIS_DEVICE; deviceNumber++)
+  {
+    QuantisCacheEvict(QUANTIS_DEVICE_USB, deviceNumber);
+  }
+#endif /* DISABLE_QUANTIS_USB */
+
+#ifndef DISABLE_QUANTIS_SIM
+  for (deviceNumber = 0; deviceNumber < MAX_QUANTIS_DEVICE; deviceNumber++)
+  {
+    QuantisCacheEvict(QUANTIS_DEVICE_SIM, deviceNumber);
+  }
+#endif /* DISABLE_QUANTIS_SIM */
+}
+
+/* Returns a monotonic time in milliseconds */
+static uint64_t QuantisGetTimeMs()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000u + (uint64_t)now.tv_nsec / 1000000u;
+}
+
+/* Background thread of QUANTIS_STATUS_CHECK_BACKGROUND mode */
+static void *QuantisStatusMonitorThread(void *arg)
+{
+  QuantisDeviceHandle *deviceHandle = (QuantisDeviceHandle *)arg;
+  QuantisStatusMonitor *monitor = deviceHandle->statusMonitor;
+  struct timespec deadline;
+
+  pthread_mutex_lock(&monitor->lock);
+  while (monitor->running)
+  {
+    pthread_mutex_unlock(&monitor->lock);
+    atomic_store(&monitor->status, deviceHandle->ops->GetModulesStatus(deviceHandle));
+    pthread_mutex_lock(&monitor->lock);
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += monitor->interval / 1000u;
+    deadline.tv_nsec += (long)(monitor->interval % 1000u) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (monitor->running &&
+           (pthread_cond_timedwait(&monitor->cond, &monitor->lock, &deadline) != ETIMEDOUT))
+    {
+      /* Spurious wake up */
+    }
+  }
+  pthread_mutex_unlock(&monitor->lock);
+
+  return NULL;
+}
+
+/* Stops the background thread (if any) and frees the status monitor */
+static void QuantisStatusMonitorFree(QuantisDeviceHandle *deviceHandle)
+{
+  QuantisStatusMonitor *monitor = deviceHandle->statusMonitor;
+
+  if (!monitor)
+  {
+    return;
+  }
+
+  if (monitor->mode == QUANTIS_STATUS_CHECK_BACKGROUND)
+  {
+    pthread_mutex_lock(&monitor->lock);
+    monitor->running = 0;
+    pthread_cond_signal(&monitor->cond);
+    pthread_mutex_unlock(&monitor->lock);
+    pthread_join(monitor->thread, NULL);
+  }
+
+  pthread_cond_destroy(&monitor->cond);
+  pthread_mutex_destroy(&monitor->lock);
+  free(monitor);
+  deviceHandle->statusMonitor = NULL;
+}
+
+/*
+ * Converts the result of GetModulesStatus into a read result. Errors of the
+ * status request itself (e.g. QUANTIS_ERROR_IO on an unplugged device) are
+ * returned unchanged so that they evict the cached handle.
+ */
+static int QuantisStatusResult(int status)
+{
+  if (status < 0)
+  {
+    return status;
+  }
+
+  return (status == 0) ? QUANTIS_ERROR_INVALID_STATUS : QUANTIS_SUCCESS;
+}
+
+int QuantisCheckStatusInternal(QuantisDeviceHandle *deviceHandle, size_t size)
+{
+  QuantisStatusMonitor *monitor = deviceHandle->statusMonitor;
+  int checkNow = 0;
+  int result;
+
+  if (!monitor)
+  {
+    /* QUANTIS_STATUS_CHECK_STRICT */
+    checkNow = 1;
+  }
+  else if (monitor->mode == QUANTIS_STATUS_CHECK_BACKGROUND)
+  {
+    /* The background thread keeps the status up to date */
+    checkNow = 0;
+  }
+  else if (atomic_load(&monitor->status) <= 0)
+  {
+    /* Recovers as soon as the modules are ok again */
+    checkNow = 1;
+  }
+  else if (monitor->mode == QUANTIS_STATUS_CHECK_TIME)
+  {
+    checkNow = ((QuantisGetTimeMs() - monitor->lastCheck) >= monitor->interval);
+  }
+  else if (monitor->mode == QUANTIS_STATUS_CHECK_BYTES)
+  {
+    checkNow = (monitor->uncheckedBytes >= monitor->interval);
+  }
+
+  if (checkNow)
+  {
+    int status = deviceHandle->ops->GetModulesStatus(deviceHandle);
+    if (!monitor)
+    {
+      return QuantisStatusResult(status);
+    }
+
+    atomic_store(&monitor->status, status);
+    monitor->lastCheck = QuantisGetTimeMs();
+    monitor->uncheckedBytes = 0u;
+  }
+
+  result = QuantisStatusResult(atomic_load(&monitor->status));
+  if (result != QUANTIS_SUCCESS)
+  {
+    return result;
+  }
+
+  monitor->uncheckedBytes += size;
+
+  return QUANTIS_SUCCESS;
+}
+
 void QuantisCloseInternal(QuantisDeviceHandle *deviceHandle)
 {
   if (!deviceHandle)
@@ -144,6 +549,10 @@ void QuantisCloseInternal(QuantisDeviceHandle *deviceHandle)
     return;
   }
 
+  /* Stops the threads reading the device before the device is closed */
+  QuantisStopPrefetch(deviceHandle);
+  QuantisStatusMonitorFree(deviceHandle);
+
   /* Frees privateData */
   if (deviceHandle->ops)
   {
@@ -156,14 +565,45 @@ void QuantisCloseInternal(QuantisDeviceHandle *deviceHandle)
   deviceHandle = NULL;
 }
 
+int QuantisRescan(QuantisDeviceType deviceType)
+{
+  int result = QUANTIS_ERROR_OTHER;
+  switch (deviceType)
+  {
+#ifndef DISABLE_QUANTIS_PCI
+  case QUANTIS_DEVICE_PCI:
+    result = QuantisOperationsPci.Rescan();
+    break;
+#endif /* DISABLE_QUANTIS_PCI */
+
+#ifndef DISABLE_QUANTIS_USB
+  case QUANTIS_DEVICE_USB:
+    result = QuantisOperationsUsb.Rescan();
+    break;
+#endif /* DISABLE_QUANTIS_USB */
+
+#ifndef DISABLE_QUANTIS_SIM
+  case QUANTIS_DEVICE_SIM:
+    result = QuantisOperationsSim.Rescan();
+    break;
+#endif /* DISABLE_QUANTIS_SIM */
+
+  default:
+    result = QUANTIS_ERROR_NO_DEVICE;
+    break;
+  }
+
+  return result;
+}
+
 int QuantisGetBoardVersion(QuantisDeviceType deviceType,
                            unsigned int deviceNumber)
 {
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
@@ -172,8 +612,8 @@ int QuantisGetBoardVersion(QuantisDeviceType deviceType,
   /* Perform request */
   result = deviceHandle->ops->GetBoardVersion(deviceHandle);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -195,6 +635,12 @@ int QuantisCount(QuantisDeviceType deviceType)
     break;
 #endif /* DISABLE_QUANTIS_USB */
 
+#ifndef DISABLE_QUANTIS_SIM
+  case QUANTIS_DEVICE_SIM:
+    result = QuantisOperationsSim.Count();
+    break;
+#endif /* DISABLE_QUANTIS_SIM */
+
   default:
     result = 0;
     break;
@@ -234,6 +680,12 @@ float QuantisGetDriverVersion(QuantisDeviceType deviceType)
     break;
 #endif /* DISABLE_QUANTIS_USB */
 
+#ifndef DISABLE_QUANTIS_SIM
+  case QUANTIS_DEVICE_SIM:
+    result = QuantisOperationsSim.GetDriverVersion();
+    break;
+#endif /* DISABLE_QUANTIS_SIM */
+
   default:
     result = (float)QUANTIS_ERROR_NO_DRIVER;
     break;
@@ -249,8 +701,8 @@ char *QuantisGetManufacturer(QuantisDeviceType deviceType,
   char *sn = NULL;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return (char *)QUANTIS_NOT_AVAILABLE;
@@ -258,10 +710,9 @@ char *QuantisGetManufacturer(QuantisDeviceType deviceType,
 
   /* Perform request and copy string locally */
   sn = deviceHandle->ops->GetManufacturer(deviceHandle);
-  memcpy(manufactuer, sn, strlen(sn));
-  manufactuer[strlen(sn)] = 0;
+  QuantisCopyDeviceString(manufactuer, sn);
 
-  QuantisCloseInternal(deviceHandle);
+  QuantisReleaseInternal(deviceHandle, QUANTIS_SUCCESS);
 
   return manufactuer;
 }
@@ -284,8 +735,8 @@ int QuantisGetModulesMask(QuantisDeviceType deviceType,
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
@@ -294,8 +745,8 @@ int QuantisGetModulesMask(QuantisDeviceType deviceType,
   /* Perform request */
   result = deviceHandle->ops->GetModulesMask(deviceHandle);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -311,8 +762,8 @@ int QuantisGetModulesDataRate(QuantisDeviceType deviceType,
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
@@ -321,8 +772,8 @@ int QuantisGetModulesDataRate(QuantisDeviceType deviceType,
   /* Perform request */
   result = deviceHandle->ops->GetModulesDataRate(deviceHandle);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -333,8 +784,8 @@ int QuantisGetModulesPower(QuantisDeviceType deviceType,
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
@@ -343,8 +794,8 @@ int QuantisGetModulesPower(QuantisDeviceType deviceType,
   /* Perform request */
   result = deviceHandle->ops->GetModulesPower(deviceHandle);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -355,8 +806,8 @@ int QuantisGetModulesStatus(QuantisDeviceType deviceType,
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
@@ -365,8 +816,8 @@ int QuantisGetModulesStatus(QuantisDeviceType deviceType,
   /* Perform request */
   result = deviceHandle->ops->GetModulesStatus(deviceHandle);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -378,8 +829,8 @@ char *QuantisGetSerialNumber(QuantisDeviceType deviceType,
   char *sn = NULL;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return (char *)QUANTIS_NO_SERIAL;
@@ -387,56 +838,123 @@ char *QuantisGetSerialNumber(QuantisDeviceType deviceType,
 
   /* Perform request and copy serial number locally */
   sn = deviceHandle->ops->GetSerialNumber(deviceHandle);
-  memcpy(serialNumber, sn, strlen(sn));
-  serialNumber[strlen(sn)] = 0;
+  QuantisCopyDeviceString(serialNumber, sn);
 
-  QuantisCloseInternal(deviceHandle);
+  QuantisReleaseInternal(deviceHandle, QUANTIS_SUCCESS);
 
   return serialNumber;
 }
 
-int QuantisModulesDisable(QuantisDeviceType deviceType,
-                          unsigned int deviceNumber,
-                          int modulesMask)
+int QuantisGetDeviceInfoHandled(QuantisDeviceHandle *deviceHandle,
+                                QuantisDeviceInfo *info)
 {
   int result;
-  QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
-  if (result < 0)
+  if (deviceHandle == NULL)
   {
-    return result;
+    return QUANTIS_ERROR_IO;
+  }
+  if (info == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
   }
 
-  /* Perform request */
-  result = deviceHandle->ops->ModulesDisable(deviceHandle, modulesMask);
-
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  memset(info, 0, sizeof(QuantisDeviceInfo));
+  info->deviceType = deviceHandle->deviceType;
+  info->deviceNumber = (unsigned int)deviceHandle->deviceNumber;
+
+  /* Strings are copied into the structure: they live in the handle otherwise */
+  QuantisCopyDeviceString(info->serialNumber, deviceHandle->ops->GetSerialNumber(deviceHandle));
+  QuantisCopyDeviceString(info->manufacturer, deviceHandle->ops->GetManufacturer(deviceHandle));
+
+  info->boardVersion = deviceHandle->ops->GetBoardVersion(deviceHandle);
+  info->modulesMask = deviceHandle->ops->GetModulesMask(deviceHandle);
+  info->modulesCount = (info->modulesMask < 0) ? info->modulesMask : QuantisCountSetBits(info->modulesMask);
+  info->modulesStatus = deviceHandle->ops->GetModulesStatus(deviceHandle);
+  info->modulesPower = deviceHandle->ops->GetModulesPower(deviceHandle);
+  info->modulesDataRate = deviceHandle->ops->GetModulesDataRate(deviceHandle);
+  info->busDeviceId = deviceHandle->ops->GetBusDeviceId(deviceHandle);
+
+  /* Only a failure to talk to the device fails the whole request */
+  result = info->modulesMask;
+  if ((result == QUANTIS_ERROR_IO) || (result == QUANTIS_ERROR_NO_DEVICE))
+  {
+    return result;
+  }
 
-  return result;
+  return QUANTIS_SUCCESS;
 }
 
-int QuantisModulesEnable(QuantisDeviceType deviceType,
+int QuantisGetDeviceInfo(QuantisDeviceType deviceType,
                          unsigned int deviceNumber,
-                         int modulesMask)
+                         QuantisDeviceInfo *info)
 {
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  if (info == NULL)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* Get (cached) device handle, once for all the fields */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
   }
 
-  /* Perform request */
-  result = deviceHandle->ops->ModulesEnable(deviceHandle, modulesMask);
+  /* Perform requests */
+  result = QuantisGetDeviceInfoHandled(deviceHandle, info);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
+
+  return result;
+}
+
+int QuantisModulesDisable(QuantisDeviceType deviceType,
+                          unsigned int deviceNumber,
+                          int modulesMask)
+{
+  int result;
+  QuantisDeviceHandle *deviceHandle = NULL;
+
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  /* Perform request */
+  result = deviceHandle->ops->ModulesDisable(deviceHandle, modulesMask);
+
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
+
+  return result;
+}
+
+int QuantisModulesEnable(QuantisDeviceType deviceType,
+                         unsigned int deviceNumber,
+                         int modulesMask)
+{
+  int result;
+  QuantisDeviceHandle *deviceHandle = NULL;
+
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  /* Perform request */
+  result = deviceHandle->ops->ModulesEnable(deviceHandle, modulesMask);
+
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -448,8 +966,8 @@ int QuantisModulesReset(QuantisDeviceType deviceType,
   int result;
   QuantisDeviceHandle *deviceHandle = NULL;
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
@@ -462,8 +980,8 @@ int QuantisModulesReset(QuantisDeviceType deviceType,
     result = deviceHandle->ops->ModulesEnable(deviceHandle, modulesMask);
   }
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
 
   return result;
 }
@@ -526,6 +1044,12 @@ int QuantisOpenInternal(QuantisDeviceType deviceType,
     break;
 #endif /* DISABLE_QUANTIS_USB */
 
+#ifndef DISABLE_QUANTIS_SIM
+  case QUANTIS_DEVICE_SIM:
+    quantisOperations = &QuantisOperationsSim;
+    break;
+#endif /* DISABLE_QUANTIS_SIM */
+
   default:
     return QUANTIS_ERROR_NO_DEVICE;
     break;
@@ -543,9 +1067,18 @@ int QuantisOpenInternal(QuantisDeviceType deviceType,
   _deviceHandle->deviceType = deviceType;
   _deviceHandle->ops = quantisOperations;
   _deviceHandle->privateData = NULL;
+  _deviceHandle->statusMonitor = NULL;
+  _deviceHandle->prefetcher = NULL;
 
   /* Open device */
   result = _deviceHandle->ops->Open(_deviceHandle);
+  if ((result >= 0) && (defaultStatusCheckMode != QUANTIS_STATUS_CHECK_STRICT))
+  {
+    result = QuantisSetStatusCheck(_deviceHandle,
+                                   defaultStatusCheckMode,
+                                   defaultStatusCheckInterval);
+  }
+
   if (result < 0)
   {
     /* Error while opening device */
@@ -575,23 +1108,50 @@ int QuantisRead(QuantisDeviceType deviceType,
     return QUANTIS_ERROR_INVALID_READ_SIZE;
   }
 
-  /* Open device */
-  result = QuantisOpenInternal(deviceType, deviceNumber, &deviceHandle);
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
   if (result < 0)
   {
     return result;
   }
 
   /* Read data */
-  result = deviceHandle->ops->Read(deviceHandle, buffer, size);
+  result = QuantisReadInternal(deviceHandle, buffer, size);
 
-  /* Close device */
-  QuantisCloseInternal(deviceHandle);
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
   deviceHandle = NULL;
 
   return result;
 }
 
+void QuantisReleaseInternal(QuantisDeviceHandle *deviceHandle, int result)
+{
+  QuantisCacheEntry *entry = NULL;
+
+  if (!deviceHandle)
+  {
+    return;
+  }
+
+  entry = QuantisCacheGetEntry(deviceHandle->deviceType,
+                               deviceHandle->deviceNumber,
+                               0);
+  if (!entry)
+  {
+    return;
+  }
+
+  /* Invalidates the handle, it will be opened again on next request */
+  if (QuantisIsHandleError(result))
+  {
+    QuantisCloseInternal(entry->deviceHandle);
+    entry->deviceHandle = NULL;
+  }
+
+  pthread_mutex_unlock(&entry->lock);
+}
+
 int QuantisOpen(QuantisDeviceType deviceType,
                 unsigned int deviceNumber,
                 QuantisDeviceHandle **deviceHandle)
@@ -627,11 +1187,173 @@ int QuantisReadHandled(QuantisDeviceHandle *deviceHandle,
   }
 
   // Read data
-  result = deviceHandle->ops->Read(deviceHandle, buffer, size);
+  result = QuantisReadInternal(deviceHandle, buffer, size);
 
   return result;
 }
 
+int QuantisReadInternal(QuantisDeviceHandle *deviceHandle,
+                        void *buffer,
+                        size_t size)
+{
+  if (deviceHandle->prefetcher)
+  {
+    return QuantisPrefetchRead(deviceHandle, buffer, size);
+  }
+
+  return deviceHandle->ops->Read(deviceHandle, buffer, size);
+}
+
+int QuantisSetPrefetch(QuantisDeviceType deviceType,
+                       unsigned int deviceNumber,
+                       size_t bufferSize)
+{
+  int result;
+  QuantisCacheEntry *entry = NULL;
+  QuantisDeviceHandle *deviceHandle = NULL;
+
+  if (bufferSize > QUANTIS_MAX_READ_SIZE)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* Get (cached) device handle */
+  result = QuantisAcquireInternal(deviceType, deviceNumber, &deviceHandle);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  /* Acquire succeeded, so the entry exists and is locked by this thread */
+  entry = QuantisCacheGetEntry(deviceType, deviceNumber, 0);
+
+  if (bufferSize > 0u)
+  {
+    result = QuantisStartPrefetch(deviceHandle, bufferSize);
+  }
+  else
+  {
+    QuantisStopPrefetch(deviceHandle);
+  }
+
+  if (result >= 0)
+  {
+    entry->prefetchSize = bufferSize;
+  }
+
+  /* Release device */
+  QuantisReleaseInternal(deviceHandle, result);
+
+  return result;
+}
+
+int QuantisSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                           size_t transferSize,
+                           unsigned int transfersCount)
+{
+  int result;
+  size_t prefetchSize;
+
+  if (deviceHandle == NULL)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  /* The prefetch thread must not read while the pipeline is changed */
+  prefetchSize = QuantisPrefetchGetSize(deviceHandle);
+  QuantisStopPrefetch(deviceHandle);
+
+  result = deviceHandle->ops->SetReadPipeline(deviceHandle,
+                                              transferSize,
+                                              transfersCount);
+
+  if (prefetchSize > 0u)
+  {
+    int prefetchResult = QuantisStartPrefetch(deviceHandle, prefetchSize);
+    if (result >= 0)
+    {
+      result = prefetchResult;
+    }
+  }
+
+  return result;
+}
+
+int QuantisSetStatusCheck(QuantisDeviceHandle *deviceHandle,
+                          QuantisStatusCheckMode mode,
+                          unsigned int interval)
+{
+  QuantisStatusMonitor *monitor = NULL;
+
+  if (deviceHandle == NULL)
+  {
+    return QUANTIS_ERROR_IO;
+  }
+
+  if ((mode < QUANTIS_STATUS_CHECK_STRICT) ||
+      (mode > QUANTIS_STATUS_CHECK_BACKGROUND) ||
+      ((mode != QUANTIS_STATUS_CHECK_STRICT) && (interval == 0u)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  QuantisStatusMonitorFree(deviceHandle);
+  if (mode == QUANTIS_STATUS_CHECK_STRICT)
+  {
+    return QUANTIS_SUCCESS;
+  }
+
+  monitor = (QuantisStatusMonitor *)malloc(sizeof(QuantisStatusMonitor));
+  if (!monitor)
+  {
+    return QUANTIS_ERROR_NO_MEMORY;
+  }
+
+  monitor->mode = mode;
+  monitor->interval = interval;
+  monitor->lastCheck = 0u;
+  monitor->uncheckedBytes = 0u;
+  monitor->running = 0;
+  /* Forces a check on first read */
+  atomic_init(&monitor->status, 0);
+  pthread_mutex_init(&monitor->lock, NULL);
+  pthread_cond_init(&monitor->cond, NULL);
+  deviceHandle->statusMonitor = monitor;
+
+  if (mode == QUANTIS_STATUS_CHECK_BACKGROUND)
+  {
+    /* Gets the status before first read */
+    atomic_store(&monitor->status, deviceHandle->ops->GetModulesStatus(deviceHandle));
+
+    monitor->running = 1;
+    if (pthread_create(&monitor->thread, NULL, QuantisStatusMonitorThread, deviceHandle) != 0)
+    {
+      /* Nothing to join */
+      monitor->mode = QUANTIS_STATUS_CHECK_STRICT;
+      QuantisStatusMonitorFree(deviceHandle);
+      return QUANTIS_ERROR_OTHER;
+    }
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisSetDefaultStatusCheck(QuantisStatusCheckMode mode,
+                                 unsigned int interval)
+{
+  if ((mode < QUANTIS_STATUS_CHECK_STRICT) ||
+      (mode > QUANTIS_STATUS_CHECK_BACKGROUND) ||
+      ((mode != QUANTIS_STATUS_CHECK_STRICT) && (interval == 0u)))
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  defaultStatusCheckMode = mode;
+  defaultStatusCheckInterval = interval;
+
+  return QUANTIS_SUCCESS;
+}
+
 int QuantisReadDouble_01(QuantisDeviceType deviceType,
                          unsigned int deviceNumber,
                          double *value)
@@ -776,65 +1498,348 @@ int QuantisReadScaledInt(QuantisDeviceType deviceType,
                          int min,
                          int max)
 {
-  int tmp;
-  int result;
+  return QuantisReadScaledIntArray(deviceType, deviceNumber, value, 1u, min, max);
+}
+
+int QuantisReadScaledShort(QuantisDeviceType deviceType,
+                           unsigned int deviceNumber,
+                           short *value,
+                           short min,
+                           short max)
+{
+  return QuantisReadScaledShortArray(deviceType, deviceNumber, value, 1u, min, max);
+}
 
-  const int BITS = sizeof(tmp) * 8;
-  const unsigned long long RANGE = max - min + 1;
-  const unsigned long long MAX_RANGE = 1ull << BITS;
-  const unsigned long long LIMIT = MAX_RANGE - (MAX_RANGE % RANGE);
+/*
+ * Reads count values of valueSize bytes into values, in requests of at most
+ * QUANTIS_MAX_READ_SIZE bytes.
+ */
+static int QuantisReadArrayInternal(QuantisDeviceType deviceType,
+                                    unsigned int deviceNumber,
+                                    void *values,
+                                    size_t count,
+                                    size_t valueSize)
+{
+  const size_t maxChunkSize = QUANTIS_MAX_READ_SIZE - (QUANTIS_MAX_READ_SIZE % valueSize);
+  unsigned char *buffer = (unsigned char *)values;
+  size_t size = count * valueSize;
+  size_t readBytes = 0u;
 
-  if (min > max)
+  if ((values == NULL) && (count > 0u))
   {
     return QUANTIS_ERROR_INVALID_PARAMETER;
   }
 
-  // Chooses the highest number that is the largest multiple of the output range
-  // (discard values higher the output range)
-  do
+  if (count > SIZE_MAX / valueSize)
+  {
+    return QUANTIS_ERROR_INVALID_READ_SIZE;
+  }
+
+  while (readBytes < size)
   {
-    result = QuantisReadInt(deviceType, deviceNumber, &tmp);
-    if (result != QUANTIS_SUCCESS)
+    size_t chunkSize = size - readBytes;
+    int result;
+
+    if (chunkSize > maxChunkSize)
+    {
+      chunkSize = maxChunkSize;
+    }
+
+    result = QuantisRead(deviceType, deviceNumber, buffer + readBytes, chunkSize);
+    if (result < 0)
     {
       return result;
     }
-  } while ((tmp > 0) && ((unsigned long long)tmp >= LIMIT));
+    else if ((size_t)result != chunkSize)
+    {
+      return QUANTIS_ERROR_IO;
+    }
 
-  *value = (tmp % RANGE) + min;
+    readBytes += chunkSize;
+  }
 
   return QUANTIS_SUCCESS;
 }
 
-int QuantisReadScaledShort(QuantisDeviceType deviceType,
-                           unsigned int deviceNumber,
-                           short *value,
-                           short min,
-                           short max)
+/* Size (in bytes) of the random words kept for the next bounded reads */
+#define QUANTIS_BOUNDED_SPARE_SIZE 1024u
+
+/*
+ * Random words read in excess by the bounded reads of a thread, to be used
+ * by its next bounded reads on the same device. They are only handed out by
+ * the thread which read them, so they can never be returned twice.
+ */
+typedef struct QuantisBoundedSpare
+{
+  QuantisDeviceType deviceType;
+  unsigned int deviceNumber;
+  size_t offset;
+  size_t length;
+  unsigned char bytes[QUANTIS_BOUNDED_SPARE_SIZE];
+} QuantisBoundedSpare;
+
+static _Thread_local QuantisBoundedSpare boundedSpare;
+
+/*
+ * Fills values with count unbiased integers in [0, range) of valueSize bytes
+ * (2 or 4), range 0 meaning the full range of the type.
+ *
+ * Words are converted in place. Large requests are read directly, smaller
+ * ones, including the words replacing rejected ones, are read with some
+ * slack into the spare words of the thread, so that a rejection almost never
+ * costs another device read. Unused slack is kept for the next requests
+ * instead of being thrown away.
+ */
+static int QuantisReadBoundedArrayInternal(QuantisDeviceType deviceType,
+                                           unsigned int deviceNumber,
+                                           void *values,
+                                           size_t count,
+                                           size_t valueSize,
+                                           uint32_t range)
+{
+  QuantisBoundedSpare *spare = &boundedSpare;
+  unsigned char *output = (unsigned char *)values;
+  size_t filled = 0u;
+
+  while (filled < count)
+  {
+    size_t missing = count - filled;
+    unsigned char *input = output + filled * valueSize;
+    size_t spareWords = 0u;
+    size_t wordsCount;
+    int result;
+
+    if ((spare->deviceType == deviceType) && (spare->deviceNumber == deviceNumber))
+    {
+      spareWords = (spare->length - spare->offset) / valueSize;
+    }
+
+    if ((spareWords == 0u) && (missing < QUANTIS_BOUNDED_SPARE_SIZE / valueSize / 2u))
+    {
+      /* Half of the words could be rejected for the worst ranges */
+      spareWords = missing + missing / 2u + 8u;
+      if (spareWords > QUANTIS_BOUNDED_SPARE_SIZE / valueSize)
+      {
+        spareWords = QUANTIS_BOUNDED_SPARE_SIZE / valueSize;
+      }
+
+      spare->length = 0u;
+      result = QuantisReadArrayInternal(deviceType, deviceNumber, spare->bytes, spareWords, valueSize);
+      if (result < 0)
+      {
+        return result;
+      }
+      spare->deviceType = deviceType;
+      spare->deviceNumber = deviceNumber;
+      spare->offset = 0u;
+      spare->length = spareWords * valueSize;
+    }
+
+    if (spareWords > 0u)
+    {
+      /* Takes the words from the spare ones */
+      wordsCount = (spareWords < missing) ? spareWords : missing;
+      memcpy(input, spare->bytes + spare->offset, wordsCount * valueSize);
+      spare->offset += wordsCount * valueSize;
+    }
+    else
+    {
+      wordsCount = missing;
+      result = QuantisReadArrayInternal(deviceType, deviceNumber, input, wordsCount, valueSize);
+      if (result < 0)
+      {
+        return result;
+      }
+    }
+
+    if (valueSize == sizeof(uint16_t))
+    {
+      filled += ConvertToBoundedArray16(input,
+                                        wordsCount,
+                                        (uint16_t)range,
+                                        (uint16_t *)(void *)(output + filled * valueSize),
+                                        missing,
+                                        NULL);
+    }
+    else
+    {
+      filled += ConvertToBoundedArray32(input,
+                                        wordsCount,
+                                        range,
+                                        (uint32_t *)(void *)(output + filled * valueSize),
+                                        missing,
+                                        NULL);
+    }
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisReadDoubleArray_01(QuantisDeviceType deviceType,
+                              unsigned int deviceNumber,
+                              double *values,
+                              size_t count)
+{
+  int result = QuantisReadArrayInternal(deviceType, deviceNumber, values, count, sizeof(*values));
+  if (result < 0)
+  {
+    return result;
+  }
+
+  /* Converts random bytes in place */
+  ConvertToDoubleArray_01(values, values, count);
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisReadFloatArray_01(QuantisDeviceType deviceType,
+                             unsigned int deviceNumber,
+                             float *values,
+                             size_t count)
+{
+  int result = QuantisReadArrayInternal(deviceType, deviceNumber, values, count, sizeof(*values));
+  if (result < 0)
+  {
+    return result;
+  }
+
+  /* Converts random bytes in place */
+  ConvertToFloatArray_01(values, values, count);
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisReadIntArray(QuantisDeviceType deviceType,
+                        unsigned int deviceNumber,
+                        int *values,
+                        size_t count)
+{
+  return QuantisReadArrayInternal(deviceType, deviceNumber, values, count, sizeof(*values));
+}
+
+int QuantisReadShortArray(QuantisDeviceType deviceType,
+                          unsigned int deviceNumber,
+                          short *values,
+                          size_t count)
+{
+  return QuantisReadArrayInternal(deviceType, deviceNumber, values, count, sizeof(*values));
+}
+
+int QuantisReadScaledDoubleArray(QuantisDeviceType deviceType,
+                                 unsigned int deviceNumber,
+                                 double *values,
+                                 size_t count,
+                                 double min,
+                                 double max)
 {
-  short tmp;
   int result;
-  const int BITS = sizeof(tmp) * 8;
-  const unsigned int RANGE = max - min + 1;
-  const unsigned int MAX_RANGE = 1u << BITS;
-  const unsigned int LIMIT = MAX_RANGE - (MAX_RANGE % RANGE);
 
   if (min > max)
   {
     return QUANTIS_ERROR_INVALID_PARAMETER;
   }
 
-  // Chooses the highest number that is the largest multiple of the output range
-  // (discard values higher the output range)
-  do
+  result = QuantisReadDoubleArray_01(deviceType, deviceNumber, values, count);
+  if (result < 0)
   {
-    result = QuantisReadShort(deviceType, deviceNumber, &tmp);
-    if (result != QUANTIS_SUCCESS)
-    {
-      return result;
-    }
-  } while ((tmp > 0) && ((unsigned int)tmp >= LIMIT));
+    return result;
+  }
+
+  ScaleDoubleArray(values, count, min, max);
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisReadScaledFloatArray(QuantisDeviceType deviceType,
+                                unsigned int deviceNumber,
+                                float *values,
+                                size_t count,
+                                float min,
+                                float max)
+{
+  int result;
+
+  if (min > max)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  result = QuantisReadFloatArray_01(deviceType, deviceNumber, values, count);
+  if (result < 0)
+  {
+    return result;
+  }
+
+  ScaleFloatArray(values, count, min, max);
+
+  return QUANTIS_SUCCESS;
+}
 
-  *value = (tmp % RANGE) + min;
+int QuantisReadScaledIntArray(QuantisDeviceType deviceType,
+                              unsigned int deviceNumber,
+                              int *values,
+                              size_t count,
+                              int min,
+                              int max)
+{
+  size_t i;
+  int result;
+
+  if (min > max)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  /* A range of 2^32 wraps to 0, which the conversion takes as the full range */
+  result = QuantisReadBoundedArrayInternal(deviceType,
+                                           deviceNumber,
+                                           values,
+                                           count,
+                                           sizeof(*values),
+                                           (uint32_t)((int64_t)max - (int64_t)min + 1));
+  if (result < 0)
+  {
+    return result;
+  }
+
+  for (i = 0u; i < count; i++)
+  {
+    values[i] = (int)((int64_t)min + (int64_t)(uint32_t)values[i]);
+  }
+
+  return QUANTIS_SUCCESS;
+}
+
+int QuantisReadScaledShortArray(QuantisDeviceType deviceType,
+                                unsigned int deviceNumber,
+                                short *values,
+                                size_t count,
+                                short min,
+                                short max)
+{
+  size_t i;
+  int result;
+
+  if (min > max)
+  {
+    return QUANTIS_ERROR_INVALID_PARAMETER;
+  }
+
+  result = QuantisReadBoundedArrayInternal(deviceType,
+                                           deviceNumber,
+                                           values,
+                                           count,
+                                           sizeof(*values),
+                                           (uint32_t)(uint16_t)(max - min + 1));
+  if (result < 0)
+  {
+    return result;
+  }
+
+  for (i = 0u; i < count; i++)
+  {
+    values[i] = (short)(min + (int)(uint16_t)values[i]);
+  }
 
   return QUANTIS_SUCCESS;
 }
@@ -921,6 +1926,12 @@ char *QuantisFullStrError(QuantisDeviceType deviceType, QuantisError errorNumber
       break;
 #endif /* DISABLE_QUANTIS_USB */
 
+#ifndef DISABLE_QUANTIS_SIM
+    case QUANTIS_DEVICE_SIM:
+      msg = QuantisOperationsSim.QuantisTypeStrError(errorNumber);
+      break;
+#endif /* DISABLE_QUANTIS_SIM */
+
     default:
       break;
     }
@@ -116,11 +116,127 @@ extern "C"
    */
   void QuantisCloseInternal(QuantisDeviceHandle *deviceHandle);
 
+  /**
+   * Get a handle on the Quantis device from the handle cache, opening the
+   * device if it is not cached yet. The handle is reserved to the calling
+   * thread until QuantisReleaseInternal is called.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param deviceHandle a pointer to a pointer to a handle the device
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  int QuantisAcquireInternal(QuantisDeviceType deviceType,
+                             unsigned int deviceNumber,
+                             QuantisDeviceHandle **deviceHandle);
+
+  /**
+   * Give back a handle obtained with QuantisAcquireInternal.
+   * @param deviceHandle a pointer to a handle the device
+   * @param result the result of the last request performed on the handle.
+   * When it reports a device failure (e.g. QUANTIS_ERROR_IO), the handle is
+   * closed and removed from the cache.
+   */
+  void QuantisReleaseInternal(QuantisDeviceHandle *deviceHandle, int result);
+
+  /**
+   * Check the status of the modules before size bytes are read, according to
+   * the status check mode of the handle (see QuantisSetStatusCheck).
+   * Must be called by the Read operation of each device type.
+   * @param deviceHandle a pointer to a handle the device
+   * @param size the number of bytes about to be read.
+   * @return QUANTIS_SUCCESS when the modules can be read,
+   * QUANTIS_ERROR_INVALID_STATUS when no module is ok, or the error of the
+   * status request itself (which evicts the handle from the cache).
+   */
+  int QuantisCheckStatusInternal(QuantisDeviceHandle *deviceHandle, size_t size);
+
   /**
    * Count the number of bits in values that are set (that is they are 1)
    */
   int QuantisCountSetBits(int value);
 
+  /**
+   * Read random data from the device, from the prefetch buffer when prefetch
+   * is started on the handle.
+   * @param deviceHandle a pointer to a handle the device
+   * @param buffer a pointer to a destination buffer.
+   * @param size the number of bytes to read.
+   * @return The number of read bytes on success or a QUANTIS_ERROR code on failure.
+   */
+  int QuantisReadInternal(QuantisDeviceHandle *deviceHandle,
+                          void *buffer,
+                          size_t size);
+
+  /******************** Prefetch functions declarations ********************
+   *
+   * Definition of prefetch functions is in QuantisPrefetch.c
+   *
+   */
+
+  /**
+   * Copy size bytes from the prefetch buffer of the handle, waiting for the
+   * prefetch thread when the buffer is empty.
+   * @return The number of read bytes on success or a QUANTIS_ERROR code on failure.
+   */
+  int QuantisPrefetchRead(QuantisDeviceHandle *deviceHandle,
+                          void *buffer,
+                          size_t size);
+
+  /**
+   * @return the size of the prefetch buffer of the handle or 0 when prefetch
+   * is not started.
+   */
+  size_t QuantisPrefetchGetSize(QuantisDeviceHandle *deviceHandle);
+
+  /********************* Memory functions declarations *********************
+   *
+   * Definition of memory functions is in QuantisMemory.c
+   *
+   */
+
+  /**
+   * A large buffer, allocated according to the memory mode of the library.
+   */
+  typedef struct QuantisBuffer
+  {
+    unsigned char *data;
+
+    /* Allocated size, may be larger than requested */
+    size_t size;
+  } QuantisBuffer;
+
+  /**
+   * Allocate a buffer of at least size bytes, with hugepages when the memory
+   * mode asks for it, and preferably on numaNode (-1 for no preference).
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  int QuantisBufferAlloc(QuantisBuffer *buffer, size_t size, int numaNode);
+
+  /**
+   * Release a buffer allocated with QuantisBufferAlloc.
+   */
+  void QuantisBufferFree(QuantisBuffer *buffer);
+
+  /********************* io_uring functions declarations *********************
+   *
+   * Definition of io_uring functions is in QuantisUring.c
+   *
+   */
+
+  /**
+   * Create a read engine queuing reads on the file descriptors of the
+   * devices with io_uring, or reading the devices in turn with
+   * QuantisReadHandled when fds is NULL.
+   * @return QUANTIS_SUCCESS on success, QUANTIS_ERROR_OPERATION_NOT_SUPPORTED
+   * when io_uring is not available or another QUANTIS_ERROR code on failure.
+   */
+  int QuantisUringCreateInternal(QuantisDeviceHandle **deviceHandles,
+                                 const int *fds,
+                                 unsigned int devicesCount,
+                                 size_t transferSize,
+                                 unsigned int transfersCount,
+                                 QuantisUring **uring);
+
   /******************** Quantis PCI functions declarations ********************
    *
    * Definition of Quantis PCI function is in QuantisPci_MyOs.c
@@ -171,12 +287,23 @@ extern "C"
 
   int QuantisPciGetBusDeviceId(QuantisDeviceHandle *deviceHandle);
 
+  /**
+   * @return the file descriptor of the device or a QUANTIS_ERROR code on failure.
+   */
+  int QuantisPciGetFd(QuantisDeviceHandle *deviceHandle);
+
   char *QuantisPciTypeStrError(int errorNumber);
 
   int QuantisPciGetAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle);
 
   int QuantisPciClearAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle);
 
+  int QuantisPciRescan();
+
+  int QuantisPciSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                               size_t transferSize,
+                               unsigned int transfersCount);
+
 #endif /* DISABLE_QUANTIS_PCI */
 
   /******************** Quantis USB functions declarations ********************
@@ -229,8 +356,72 @@ extern "C"
 
   int QuantisUsbClearAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle);
 
+  int QuantisUsbRescan();
+
+  int QuantisUsbSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                               size_t transferSize,
+                               unsigned int transfersCount);
+
 #endif /* DISABLE_QUANTIS_USB */
 
+  /******************** Quantis simulator functions declarations ********************
+   *
+   * Definition of Quantis simulator function is in QuantisSim.c
+   *
+   */
+
+#ifndef DISABLE_QUANTIS_SIM
+
+  int QuantisSimBoardReset(QuantisDeviceHandle *deviceHandle);
+
+  void QuantisSimClose(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimCount();
+
+  int QuantisSimGetBoardVersion(QuantisDeviceHandle *deviceHandle);
+
+  float QuantisSimGetDriverVersion();
+
+  char *QuantisSimGetManufacturer(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimGetModulesMask(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimGetModulesDataRate(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimGetModulesPower(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimGetModulesStatus(QuantisDeviceHandle *deviceHandle);
+
+  char *QuantisSimGetSerialNumber(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimModulesDisable(QuantisDeviceHandle *deviceHandle,
+                               int moduleMask);
+
+  int QuantisSimModulesEnable(QuantisDeviceHandle *deviceHandle,
+                              int moduleMask);
+
+  int QuantisSimOpen(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimRead(QuantisDeviceHandle *deviceHandle,
+                     void *buffer,
+                     size_t size);
+
+  int QuantisSimGetBusDeviceId(QuantisDeviceHandle *deviceHandle);
+
+  char *QuantisSimTypeStrError(int errorNumber);
+
+  int QuantisSimGetAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimClearAis31StartupTestsRequestFlag(QuantisDeviceHandle *deviceHandle);
+
+  int QuantisSimRescan();
+
+  int QuantisSimSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                               size_t transferSize,
+                               unsigned int transfersCount);
+
+#endif /* DISABLE_QUANTIS_SIM */
+
 #ifdef __cplusplus
 }
 #endif
@@ -72,10 +72,13 @@ extern "C"
     QUANTIS_DEVICE_PCI = 1,
 
     /** Quantis USB */
-    QUANTIS_DEVICE_USB = 2
+    QUANTIS_DEVICE_USB = 2,
+
+    /** Software simulator of a Quantis device (see QuantisSimSetConfig) */
+    QUANTIS_DEVICE_SIM = 4
 
     /* Next Quantis device type
-    QUANTIS_DEVICE_XXX = 4 */
+    QUANTIS_DEVICE_XXX = 8 */
   } QuantisDeviceType;
 
   /**
@@ -119,6 +122,49 @@ extern "C"
     QUANTIS_ERROR_OTHER = -199
   } QuantisError;
 
+  /**
+   * How the status of the modules is checked while reading random data.
+   */
+  DLL_EXPORT typedef enum {
+    /** Status is requested to the device before every transfer (default) */
+    QUANTIS_STATUS_CHECK_STRICT = 0,
+
+    /** Status is requested when interval milliseconds elapsed since last check */
+    QUANTIS_STATUS_CHECK_TIME = 1,
+
+    /** Status is requested each time interval bytes have been read */
+    QUANTIS_STATUS_CHECK_BYTES = 2,
+
+    /** Status is requested every interval milliseconds by a background thread */
+    QUANTIS_STATUS_CHECK_BACKGROUND = 3
+  } QuantisStatusCheckMode;
+
+  /**
+   * How an aggregate of devices shares requests between its devices.
+   */
+  DLL_EXPORT typedef enum {
+    /** Every device reads the same amount of data */
+    QUANTIS_SHARE_FAIR = 0,
+
+    /** Every device reads an amount of data proportional to its data rate */
+    QUANTIS_SHARE_WEIGHTED = 1
+  } QuantisAggregateShareMode;
+
+  /**
+   * How the large buffers of the library (prefetch buffers, pools) are
+   * allocated.
+   */
+  DLL_EXPORT typedef enum {
+    /** Regular pages (default) */
+    QUANTIS_MEMORY_DEFAULT = 0,
+
+    /** Reserved hugepages (MAP_HUGETLB), transparent hugepages when none is free */
+    QUANTIS_MEMORY_HUGEPAGES = 1,
+
+    /** Transparent hugepages (madvise(MADV_HUGEPAGE)) */
+    QUANTIS_MEMORY_TRANSPARENT_HUGEPAGES = 2
+  } QuantisMemoryMode;
+
   /**
    * Structure representing an handle on a Quantis device. This is an opaque
    * type for which are only ever provided with a pointer, usually originating
@@ -128,6 +174,10 @@ extern "C"
 
   typedef struct QuantisOperations QuantisOperations;
 
+  typedef struct QuantisStatusMonitor QuantisStatusMonitor;
+
+  typedef struct QuantisPrefetcher QuantisPrefetcher;
+
   /**
    *
    */
@@ -137,6 +187,8 @@ extern "C"
     QuantisDeviceType deviceType;
     QuantisOperations *ops;
     void *privateData;
+    QuantisStatusMonitor *statusMonitor;
+    QuantisPrefetcher *prefetcher;
   };
 
   /**
@@ -185,6 +237,12 @@ extern "C"
     int (*GetAis31StartupTestsRequestFlag)(QuantisDeviceHandle *deviceHandle);
 
     int (*ClearAis31StartupTestsRequestFlag)(QuantisDeviceHandle *deviceHandle);
+
+    int (*SetReadPipeline)(QuantisDeviceHandle *deviceHandle,
+                           size_t transferSize,
+                           unsigned int transfersCount);
+
+    int (*Rescan)();
   };
 
   /** 
@@ -209,6 +267,26 @@ extern "C"
   DLL_EXPORT int QuantisBoardReset(QuantisDeviceType deviceType,
                                    unsigned int deviceNumber);
 
+  /**
+   * Close the cached handle of a Quantis device.
+   *
+   * All functions taking a deviceType and a deviceNumber keep the device open
+   * between calls. The handle is automatically closed on I/O errors and
+   * reopened on next call. This function explicitly closes it, for instance
+   * before the device is opened with QuantisOpen (a Quantis USB can only be
+   * claimed once).
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   */
+  DLL_EXPORT void QuantisCacheEvict(QuantisDeviceType deviceType,
+                                    unsigned int deviceNumber);
+
+  /**
+   * Close the cached handles of all Quantis devices.
+   * @see QuantisCacheEvict
+   */
+  DLL_EXPORT void QuantisCacheEvictAll();
+
   /**
    * Returns the number of specific Quantis type devices that have been detected
    * on the system.
@@ -218,6 +296,21 @@ extern "C"
    */
   DLL_EXPORT int QuantisCount(QuantisDeviceType deviceType);
 
+  /**
+   * Search again the Quantis devices of a specific type attached to the system.
+   *
+   * The list of Quantis USB devices is kept in memory while the library uses
+   * the devices, and is updated automatically when the system reports devices
+   * being plugged or unplugged (libusb hotplug). On systems without hotplug
+   * support, this function must be called after a device has been plugged or
+   * unplugged.
+   * @param deviceType specify the type of Quantis device.
+   * @return the number of Quantis devices that have been detected on the
+   * system or a QUANTIS_ERROR code on failure.
+   * @warning Device numbers may change after a rescan.
+   */
+  DLL_EXPORT int QuantisRescan(QuantisDeviceType deviceType);
+
   /**
    * Get the version of the board.
    * @param deviceType specify the type of Quantis device.
@@ -310,6 +403,52 @@ extern "C"
   DLL_EXPORT int QuantisGetModulesStatus(QuantisDeviceType deviceType,
                                          unsigned int deviceNumber);
 
+  /** Size of the strings of QuantisDeviceInfo, terminating zero included */
+#define QUANTIS_DEVICE_INFO_STRING_LENGTH 256
+
+  /**
+   * Snapshot of the information of a device. See QuantisGetDeviceInfo.
+   * Integer fields hold a QUANTIS_ERROR code when the device does not
+   * support the corresponding request.
+   */
+  typedef struct QuantisDeviceInfo
+  {
+    QuantisDeviceType deviceType;
+    unsigned int deviceNumber;
+    int boardVersion;
+    char serialNumber[QUANTIS_DEVICE_INFO_STRING_LENGTH];
+    char manufacturer[QUANTIS_DEVICE_INFO_STRING_LENGTH];
+    int modulesCount;
+    int modulesMask;
+    int modulesStatus;
+    int modulesPower;
+    int modulesDataRate;
+    /** PCI bus number in bits 8-15 and device number in bits 0-7 (PCI only) */
+    int busDeviceId;
+  } QuantisDeviceInfo;
+
+  /**
+   * Get all the information of a device with a single opening of the device.
+   * Unlike QuantisGetSerialNumber and QuantisGetManufacturer, strings are
+   * copied into the caller's structure, so this function is reentrant.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param info a pointer to the structure to fill.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisGetDeviceInfo(QuantisDeviceType deviceType,
+                                      unsigned int deviceNumber,
+                                      QuantisDeviceInfo *info);
+
+  /**
+   * Same as QuantisGetDeviceInfo, on an opened device.
+   * @param deviceHandle a pointer to a handle the device
+   * @param info a pointer to the structure to fill.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisGetDeviceInfoHandled(QuantisDeviceHandle *deviceHandle,
+                                             QuantisDeviceInfo *info);
+
   /**
    * Get a pointer to the serial number string of the Quantis device.
    * @param deviceType specify the type of Quantis device.
@@ -393,6 +532,97 @@ extern "C"
    */
   DLL_EXPORT void QuantisClose(QuantisDeviceHandle *deviceHandle);
 
+  /**
+   * Configure how the device is read by QuantisReadHandled: random data is
+   * requested in transfers of transferSize bytes, and up to transfersCount
+   * transfers are kept in flight so the device never waits for the host.
+   * Larger transfers and more transfers in flight improve the throughput of
+   * large reads, at the cost of memory.
+   * @param deviceHandle a pointer to a handle the device
+   * @param transferSize the size (in bytes) of a transfer, or 0 to use the
+   * default size. It is rounded up to the packet size of the device.
+   * @param transfersCount the number of transfers in flight, or 0 to use the
+   * default count.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @note Quantis PCI is then read with io_uring on Linux, and keeps being read
+   * with blocking read() calls when io_uring is not available.
+   */
+  DLL_EXPORT int QuantisSetReadPipeline(QuantisDeviceHandle *deviceHandle,
+                                        size_t transferSize,
+                                        unsigned int transfersCount);
+
+  /**
+   * Select how the status of the modules is checked when reading random data
+   * from the device.
+   *
+   * In QUANTIS_STATUS_CHECK_STRICT mode, the status is requested before
+   * every transfer, which doubles the number of requests sent to a Quantis
+   * USB. Other modes only request the status on an interval and keep the
+   * last known status in memory. Once the known status is bad, reads fail
+   * immediately with QUANTIS_ERROR_INVALID_STATUS (or with the error of the
+   * status request, e.g. QUANTIS_ERROR_IO when the device is unplugged).
+   * @param deviceHandle a pointer to a handle the device
+   * @param mode the status check mode.
+   * @param interval the interval (in milliseconds for QUANTIS_STATUS_CHECK_TIME
+   * and QUANTIS_STATUS_CHECK_BACKGROUND, in bytes for QUANTIS_STATUS_CHECK_BYTES)
+   * between two checks. Ignored in QUANTIS_STATUS_CHECK_STRICT mode.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisSetStatusCheck(QuantisDeviceHandle *deviceHandle,
+                                       QuantisStatusCheckMode mode,
+                                       unsigned int interval);
+
+  /**
+   * Select the status check mode of devices opened afterwards, including the
+   * cached handles used by functions taking a deviceType and a deviceNumber.
+   * @param mode the status check mode.
+   * @param interval the interval between two checks.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisSetStatusCheck
+   * @warning Handles already cached keep their mode until they are evicted.
+   */
+  DLL_EXPORT int QuantisSetDefaultStatusCheck(QuantisStatusCheckMode mode,
+                                              unsigned int interval);
+
+  /**
+   * Start a prefetch thread on the device. The thread keeps a buffer of
+   * bufferSize bytes filled with random data: it reads the device by large
+   * chunks until the buffer is full and starts again once half of the buffer
+   * has been consumed. QuantisReadHandled and the functions built on it then
+   * copy random data from memory and only wait for the device when the buffer
+   * is empty.
+   * If prefetch was already started on the device, it is restarted with the
+   * new buffer size.
+   * @param deviceHandle a pointer to a handle the device
+   * @param bufferSize the size (in bytes) of the buffer, not larger than
+   * QUANTIS_MAX_READ_SIZE. It is rounded up to a power of two.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @warning random data remaining in the buffer is lost when prefetch is
+   * stopped.
+   */
+  DLL_EXPORT int QuantisStartPrefetch(QuantisDeviceHandle *deviceHandle,
+                                      size_t bufferSize);
+
+  /**
+   * Stop the prefetch thread of the device, if any.
+   * @param deviceHandle a pointer to a handle the device
+   */
+  DLL_EXPORT void QuantisStopPrefetch(QuantisDeviceHandle *deviceHandle);
+
+  /**
+   * Start or stop prefetch on the cached handle of the device used by
+   * functions taking a deviceType and a deviceNumber. The setting is kept if
+   * the handle is reopened.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param bufferSize the size (in bytes) of the buffer or 0 to stop prefetch.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisStartPrefetch
+   */
+  DLL_EXPORT int QuantisSetPrefetch(QuantisDeviceType deviceType,
+                                    unsigned int deviceNumber,
+                                    size_t bufferSize);
+
   /**
    * Reads random data from the Quantis device.
    * This function expect the device has been previously opened
@@ -406,9 +636,62 @@ extern "C"
                                     void *buffer,
                                     size_t size);
 
+  /**
+   * Function receiving the chunks of a stream, see QuantisReadStream.
+   * @param buffer a pointer to the random data, only valid during the call.
+   * @param size the number of bytes in buffer.
+   * @param userData the pointer given to QuantisReadStream.
+   * @return 0 to continue the stream, or any other value to stop it.
+   */
+  typedef int (*QuantisStreamCallback)(const void *buffer,
+                                       size_t size,
+                                       void *userData);
+
+  /**
+   * Reads a stream of random data of any length from the Quantis device.
+   *
+   * The data is passed to callback in chunks of chunkSize bytes (the last one
+   * may be smaller), on the calling thread. While callback processes a chunk,
+   * a background thread reads the next one from the device, so only two
+   * chunks are ever held in memory.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param size the number of bytes to read, or 0 to read until callback
+   * stops the stream.
+   * @param chunkSize the size of the chunks (not larger than
+   * QUANTIS_MAX_READ_SIZE), or 0 to use chunks of 1 MiB.
+   * @param callback the function receiving the chunks.
+   * @param userData a pointer passed to callback.
+   * @return QUANTIS_SUCCESS when size bytes were read or callback stopped
+   * the stream, or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisReadStream(QuantisDeviceType deviceType,
+                                   unsigned int deviceNumber,
+                                   unsigned long long size,
+                                   size_t chunkSize,
+                                   QuantisStreamCallback callback,
+                                   void *userData);
+
+  /**
+   * Reads a stream of random data of any length from the Quantis device.
+   * This function expect the device has been previously opened
+   * @param deviceHandle a pointer to a handle the device
+   * @param size the number of bytes to read, or 0 for an unlimited stream.
+   * @param chunkSize the size of the chunks, or 0 to use chunks of 1 MiB.
+   * @param callback the function receiving the chunks.
+   * @param userData a pointer passed to callback.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadStream
+   */
+  DLL_EXPORT int QuantisReadStreamHandled(QuantisDeviceHandle *deviceHandle,
+                                          unsigned long long size,
+                                          size_t chunkSize,
+                                          QuantisStreamCallback callback,
+                                          void *userData);
+
   /**
    * Reads random data from the Quantis device.
-   * This function perform open read and close
+   * This function uses the cached handle of the device (see QuantisCacheEvict)
    * @param deviceType specify the type of Quantis device.
    * @param deviceNumber the number of the Quantis device.
    * @param buffer a pointer to a destination buffer. This buffer MUST 
@@ -531,6 +814,776 @@ extern "C"
                                         short min,
                                         short max);
 
+  /**
+   * Reads an array of random double precision floating values between 0.0
+   * (inclusive) and 1.0 (exclusive) from the Quantis device.
+   *
+   * Random data is read in bulk directly into values and converted in place,
+   * so this is much faster than calling QuantisReadDouble_01 count times.
+   * Arrays larger than QUANTIS_MAX_READ_SIZE bytes are read in several
+   * requests.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see ConvertToDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadDoubleArray_01(QuantisDeviceType deviceType,
+                                           unsigned int deviceNumber,
+                                           double *values,
+                                           size_t count);
+
+  /**
+   * Reads an array of random single precision floating values between 0.0
+   * (inclusive) and 1.0 (exclusive) from the Quantis device.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadFloatArray_01(QuantisDeviceType deviceType,
+                                          unsigned int deviceNumber,
+                                          float *values,
+                                          size_t count);
+
+  /**
+   * Reads an array of random numbers from the Quantis device.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadIntArray(QuantisDeviceType deviceType,
+                                     unsigned int deviceNumber,
+                                     int *values,
+                                     size_t count);
+
+  /**
+   * Reads an array of random numbers from the Quantis device.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadShortArray(QuantisDeviceType deviceType,
+                                       unsigned int deviceNumber,
+                                       short *values,
+                                       size_t count);
+
+  /**
+   * Reads an array of random double precision floating values scaled to be
+   * between min (inclusive) and max (exclusive).
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @param min the minimal value a random number can take.
+   * @param max the maximal value a random number can take.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadScaledDoubleArray(QuantisDeviceType deviceType,
+                                              unsigned int deviceNumber,
+                                              double *values,
+                                              size_t count,
+                                              double min,
+                                              double max);
+
+  /**
+   * Reads an array of random single precision floating values scaled to be
+   * between min (inclusive) and max (exclusive).
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @param min the minimal value a random number can take.
+   * @param max the maximal value a random number can take.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadScaledFloatArray(QuantisDeviceType deviceType,
+                                             unsigned int deviceNumber,
+                                             float *values,
+                                             size_t count,
+                                             float min,
+                                             float max);
+
+  /**
+   * Reads an array of random numbers scaled to be between min and max
+   * (inclusive). Values out of the largest multiple of the range are
+   * discarded, so every value of the range is equally likely.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @param min the minimal value a random number can take.
+   * @param max the maximal value a random number can take.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadDoubleArray_01
+   */
+  DLL_EXPORT int QuantisReadScaledIntArray(QuantisDeviceType deviceType,
+                                           unsigned int deviceNumber,
+                                           int *values,
+                                           size_t count,
+                                           int min,
+                                           int max);
+
+  /**
+   * Reads an array of random numbers scaled to be between min and max
+   * (inclusive).
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @param min the minimal value a random number can take.
+   * @param max the maximal value a random number can take.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisReadScaledIntArray
+   */
+  DLL_EXPORT int QuantisReadScaledShortArray(QuantisDeviceType deviceType,
+                                             unsigned int deviceNumber,
+                                             short *values,
+                                             size_t count,
+                                             short min,
+                                             short max);
+
+  /**
+   * Pool of random data shared by many threads. See QuantisPoolCreate.
+   */
+  typedef struct QuantisPool QuantisPool;
+
+  /**
+   * Create a pool of random data on top of one or more devices.
+   *
+   * The pool keeps segmentsCount segments of segmentSize bytes filled by a
+   * thread per device. Any number of threads can then call QuantisPoolRead
+   * concurrently: bytes are reserved with an atomic fetch-add on the current
+   * segment, so threads never wait for each other unless the pool is empty,
+   * and a given random byte is never returned twice.
+   *
+   * The handles must stay open, and must not be used by any other function,
+   * until the pool is destroyed.
+   * @param deviceHandles an array of handles on the devices.
+   * @param deviceHandlesCount the number of handles in deviceHandles.
+   * @param segmentSize the size (in bytes) of a segment, not larger than
+   * QUANTIS_MAX_READ_SIZE, or 0 to use the default size.
+   * @param segmentsCount the number of segments (from 2 to 1024), or 0 to use
+   * the default count.
+   * @param pool a pointer to a pointer to the pool.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisPoolCreate(QuantisDeviceHandle **deviceHandles,
+                                   unsigned int deviceHandlesCount,
+                                   size_t segmentSize,
+                                   unsigned int segmentsCount,
+                                   QuantisPool **pool);
+
+  /**
+   * Read random data from the pool. This function is thread safe and only
+   * waits when the pool is empty.
+   * @param pool a pointer to the pool.
+   * @param buffer a pointer to a destination buffer.
+   * @param size the number of bytes to read (not larger than QUANTIS_MAX_READ_SIZE).
+   * @return the number of read bytes on success or a QUANTIS_ERROR code on
+   * failure. An error reading a device is returned to one of the readers,
+   * after which the device is read again.
+   */
+  DLL_EXPORT int QuantisPoolRead(QuantisPool *pool,
+                                 void *buffer,
+                                 size_t size);
+
+  /**
+   * Stop the threads of the pool and release its memory. The devices are not
+   * closed. No thread may be reading from the pool anymore.
+   * @param pool a pointer to the pool.
+   */
+  DLL_EXPORT void QuantisPoolDestroy(QuantisPool *pool);
+
+  /**
+   * Create a pool of random data whose memory is placed on a given NUMA node.
+   *
+   * QuantisPoolCreate places the pool on the node of the first PCI device
+   * having a known node. On hosts with several sockets, consumers running on
+   * another node should rather read from a pool of their own node, created
+   * with distinct handles on the devices (a device may be opened several
+   * times): the data then crosses the interconnect once, when the pool is
+   * filled, instead of on every read.
+   * @param deviceHandles an array of handles on the devices.
+   * @param deviceHandlesCount the number of handles in deviceHandles.
+   * @param segmentSize the size (in bytes) of a segment, or 0 to use the
+   * default size.
+   * @param segmentsCount the number of segments, or 0 to use the default count.
+   * @param numaNode the node the memory of the pool is allocated on and its
+   * threads run on, or -1 to use the node of the devices.
+   * @param pool a pointer to a pointer to the pool.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * @see QuantisPoolCreate
+   * @see QuantisGetCurrentNumaNode
+   */
+  DLL_EXPORT int QuantisPoolCreateOnNode(QuantisDeviceHandle **deviceHandles,
+                                         unsigned int deviceHandlesCount,
+                                         size_t segmentSize,
+                                         unsigned int segmentsCount,
+                                         int numaNode,
+                                         QuantisPool **pool);
+
+  /**
+   * Configuration of the Quantis simulator (QUANTIS_DEVICE_SIM).
+   */
+  typedef struct QuantisSimConfig
+  {
+    /** Number of simulated devices */
+    unsigned int devicesCount;
+
+    /** Number of modules of each device (1 to 4) */
+    unsigned int modulesCount;
+
+    /** Data rate (in bytes per second) of a module, 0 for no limit */
+    unsigned int moduleDataRate;
+
+    /** Latency (in microseconds) of a transfer */
+    unsigned int transferLatency;
+
+    /** Size (in bytes) of a packet, the device only sends whole packets */
+    unsigned int packetSize;
+
+    /** Probability (from 0 to 1) that a status request reports failed modules */
+    double statusFailureRate;
+
+    /** File providing the random data (read in loop), or NULL to use ChaCha20 */
+    const char *sourceFile;
+
+    /** Seed of ChaCha20, or 0 to seed it from the system */
+    unsigned long long seed;
+  } QuantisSimConfig;
+
+  /**
+   * Configure the Quantis simulator. The configuration applies to simulated
+   * devices opened afterwards, including cached handles once evicted.
+   *
+   * By default, a single device with one module is simulated at the data rate
+   * of a real module.
+   * @param config a pointer to the configuration. sourceFile is copied.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisSimSetConfig(const QuantisSimConfig *config);
+
+  /**
+   * Get the current configuration of the Quantis simulator.
+   * @param config a pointer to the destination configuration.
+   */
+  DLL_EXPORT void QuantisSimGetConfig(QuantisSimConfig *config);
+
+  /**
+   * Aggregate of all the Quantis devices. See QuantisAggregateOpen.
+   */
+  typedef struct QuantisAggregate QuantisAggregate;
+
+  /**
+   * Open all the available Quantis PCI and USB devices as a single source of
+   * random data. Each device is read by its own thread, and each request is
+   * shared between the devices according to shareMode so that they are all
+   * read in parallel. Devices that cannot be opened are skipped.
+   * The aggregate uses the cached handles of the devices (see
+   * QuantisCacheEvict), so they stay usable through the functions taking a
+   * deviceType and a deviceNumber.
+   * @param shareMode how requests are shared between the devices.
+   * @param aggregate a pointer to a pointer to the aggregate.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure
+   * (QUANTIS_ERROR_NO_DEVICE when no device could be opened).
+   */
+  DLL_EXPORT int QuantisAggregateOpen(QuantisAggregateShareMode shareMode,
+                                      QuantisAggregate **aggregate);
+
+  /**
+   * Stop the threads of the aggregate and release its memory. The handles of
+   * the devices stay cached until evicted.
+   * @param aggregate a pointer to the aggregate.
+   */
+  DLL_EXPORT void QuantisAggregateClose(QuantisAggregate *aggregate);
+
+  /**
+   * @param aggregate a pointer to the aggregate.
+   * @return the number of devices in the aggregate.
+   */
+  DLL_EXPORT int QuantisAggregateCount(QuantisAggregate *aggregate);
+
+  /**
+   * Read random data from all the devices of the aggregate in parallel.
+   * Requests smaller than a few kilobytes are served by a single device.
+   * @param aggregate a pointer to the aggregate.
+   * @param buffer a pointer to a destination buffer.
+   * @param size the number of bytes to read (not larger than QUANTIS_MAX_READ_SIZE).
+   * @return the number of read bytes on success or a QUANTIS_ERROR code on
+   * failure of any of the devices.
+   */
+  DLL_EXPORT int QuantisAggregateRead(QuantisAggregate *aggregate,
+                                      void *buffer,
+                                      size_t size);
+
+  /**
+   * Pool of random bits read from a device. See QuantisBitPoolCreate.
+   */
+  typedef struct QuantisBitPool QuantisBitPool;
+
+  /**
+   * Create a pool handing out random data bit by bit, so that consumers of
+   * a few bits (a coin flip, a 2-bit or 7-bit value) do not waste the rest of
+   * a byte. Data is read from the device bufferSize bytes at once.
+   *
+   * A bit pool must not be used by several threads at the same time.
+   * @param deviceHandle a pointer to a handle the device. It must stay open
+   * until the pool is destroyed.
+   * @param bufferSize the number of bytes read from the device at once (0
+   * selects a default of 4096 bytes).
+   * @param pool a pointer to a pointer to the pool.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisBitPoolCreate(QuantisDeviceHandle *deviceHandle,
+                                      size_t bufferSize,
+                                      QuantisBitPool **pool);
+
+  /**
+   * Release the memory of the pool. The device is not closed.
+   * @param pool a pointer to the pool.
+   */
+  DLL_EXPORT void QuantisBitPoolDestroy(QuantisBitPool *pool);
+
+  /**
+   * Take random bits from the pool.
+   * @param pool a pointer to the pool.
+   * @param count the number of bits to take (0 to 64).
+   * @param bits a pointer to a destination value, receiving the bits in its
+   * count least significant bits, the others being 0.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisBitPoolTakeBits(QuantisBitPool *pool,
+                                        unsigned int count,
+                                        unsigned long long *bits);
+
+  /**
+   * Read an array of random values of bitsPerValue bits each, one value per
+   * byte. Exactly count * bitsPerValue bits are taken from the pool, eight
+   * values at a time (spread over bytes with pdep where it is fast).
+   * @param pool a pointer to the pool.
+   * @param bitsPerValue the number of random bits of each value (1 to 8).
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to read.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisBitPoolReadValues(QuantisBitPool *pool,
+                                          unsigned int bitsPerValue,
+                                          unsigned char *values,
+                                          size_t count);
+
+  /**
+   * Take bitsCount random bits from the pool and count the bits set, for
+   * example the number of heads in bitsCount coin flips.
+   * @param pool a pointer to the pool.
+   * @param bitsCount the number of bits to take.
+   * @param ones a pointer to the destination number of bits set.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisBitPoolCountOnes(QuantisBitPool *pool,
+                                         size_t bitsCount,
+                                         size_t *ones);
+
+  /**
+   * Get the statistics of the pool since its creation.
+   * @param pool a pointer to the pool.
+   * @param bitsRead if not NULL, receives the number of bits read from the
+   * device.
+   * @param bitsConsumed if not NULL, receives the number of bits taken from
+   * the pool.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisBitPoolGetStats(const QuantisBitPool *pool,
+                                        unsigned long long *bitsRead,
+                                        unsigned long long *bitsConsumed);
+
+  /**
+   * Sampler drawing bounded integers bit by bit. See QuantisSamplerCreate.
+   */
+  typedef struct QuantisSampler QuantisSampler;
+
+  /**
+   * Statistics of a sampler, see QuantisSamplerGetStats.
+   */
+  typedef struct QuantisSamplerStats
+  {
+    /** Number of random bits read from the device */
+    unsigned long long bitsRead;
+
+    /** Number of random bits used to draw values */
+    unsigned long long bitsConsumed;
+
+    /** Number of values returned */
+    unsigned long long valuesCount;
+
+    /** Entropy of the returned values, the sum of log2(max - min + 1) */
+    double bitsProduced;
+  } QuantisSamplerStats;
+
+  /**
+   * Create a sampler of bounded integers on a Quantis device.
+   *
+   * Unlike QuantisReadScaledInt, which spends 32 bits on each value, the
+   * sampler uses the Fast Dice Roller algorithm on groups of values (drawing
+   * one integer below range^k, split into k values), so that it consumes
+   * close to log2(max - min + 1) bits per value. The values left from a group
+   * are kept for the next calls with the same min and max.
+   *
+   * A sampler must not be used by several threads at the same time.
+   * @param deviceType specify the type of Quantis device.
+   * @param deviceNumber the number of the Quantis device.
+   * @param bufferSize the number of bytes read from the device at once (0
+   * selects a default of 4096 bytes).
+   * @param sampler a pointer to a pointer to the sampler.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisSamplerCreate(QuantisDeviceType deviceType,
+                                      unsigned int deviceNumber,
+                                      size_t bufferSize,
+                                      QuantisSampler **sampler);
+
+  /**
+   * Close the device of the sampler and release its memory.
+   * @param sampler a pointer to the sampler.
+   */
+  DLL_EXPORT void QuantisSamplerDestroy(QuantisSampler *sampler);
+
+  /**
+   * Draw a random number between min and max (inclusive).
+   * @param sampler a pointer to the sampler.
+   * @param value a pointer to a destination value.
+   * @param min the minimal value a random number can take.
+   * @param max the maximal value a random number can take.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisSamplerReadInt(QuantisSampler *sampler,
+                                       int *value,
+                                       int min,
+                                       int max);
+
+  /**
+   * Draw an array of random numbers between min and max (inclusive).
+   * @param sampler a pointer to the sampler.
+   * @param values a pointer to an array of count values.
+   * @param count the number of values to draw.
+   * @param min the minimal value a random number can take.
+   * @param max the maximal value a random number can take.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisSamplerReadIntArray(QuantisSampler *sampler,
+                                            int *values,
+                                            size_t count,
+                                            int min,
+                                            int max);
+
+  /**
+   * Get the statistics of the sampler since its creation. The efficiency of
+   * the sampler is bitsProduced / bitsConsumed.
+   * @param sampler a pointer to the sampler.
+   * @param stats a pointer to the destination statistics.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisSamplerGetStats(const QuantisSampler *sampler,
+                                        QuantisSamplerStats *stats);
+
+  /**
+   * Default path of the Unix domain socket of the Quantis daemon.
+   */
+#define QUANTIS_DAEMON_DEFAULT_SOCKET "/tmp/quantisd.sock"
+
+  /**
+   * Opcode of a request of random data to the Quantis daemon.
+   */
+#define QUANTIS_DAEMON_OPCODE_READ 1u
+
+  /**
+   * Request sent to the Quantis daemon, in host byte order. Requests can be
+   * pipelined: a client may send several requests before reading the
+   * responses, which come back in the same order.
+   */
+  typedef struct QuantisDaemonRequest
+  {
+    /** QUANTIS_DAEMON_OPCODE_READ */
+    unsigned int opcode;
+
+    /** Number of random bytes requested, not larger than QUANTIS_MAX_READ_SIZE */
+    unsigned int size;
+  } QuantisDaemonRequest;
+
+  /**
+   * Response of the Quantis daemon to a request.
+   */
+  typedef struct QuantisDaemonResponse
+  {
+    /** Number of random bytes following the response, or a QUANTIS_ERROR code */
+    int result;
+  } QuantisDaemonResponse;
+
+  /**
+   * Connection to the Quantis daemon. See QuantisDaemonConnect.
+   */
+  typedef struct QuantisDaemonClient QuantisDaemonClient;
+
+  /**
+   * Connect to the Quantis daemon, which owns a device and serves random data
+   * to many processes over a Unix domain socket.
+   *
+   * A connection must not be used by several threads at the same time.
+   * @param socketPath the path of the socket of the daemon, or NULL for
+   * QUANTIS_DAEMON_DEFAULT_SOCKET.
+   * @param client a pointer to a pointer to the connection.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure
+   * (QUANTIS_ERROR_NO_DEVICE when the daemon is not running).
+   */
+  DLL_EXPORT int QuantisDaemonConnect(const char *socketPath,
+                                      QuantisDaemonClient **client);
+
+  /**
+   * Close the connection to the Quantis daemon.
+   * @param client a pointer to the connection.
+   */
+  DLL_EXPORT void QuantisDaemonClose(QuantisDaemonClient *client);
+
+  /**
+   * Reads random data from the Quantis daemon.
+   * @param client a pointer to the connection.
+   * @param buffer a pointer to a destination buffer.
+   * @param size the number of bytes to read (not larger than QUANTIS_MAX_READ_SIZE).
+   * @return the number of read bytes on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisDaemonRead(QuantisDaemonClient *client,
+                                   void *buffer,
+                                   size_t size);
+
+  /**
+   * Reads several buffers of random data from the Quantis daemon. Requests
+   * are pipelined, so that the daemon serves them in as few device reads as
+   * possible and the latency of the socket is paid once per batch.
+   * @param client a pointer to the connection.
+   * @param buffers an array of count pointers to destination buffers.
+   * @param sizes an array of count sizes (not larger than QUANTIS_MAX_READ_SIZE).
+   * @param count the number of buffers.
+   * @return QUANTIS_SUCCESS when all the buffers were filled or a
+   * QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisDaemonReadBatch(QuantisDaemonClient *client,
+                                        void *const *buffers,
+                                        const size_t *sizes,
+                                        size_t count);
+
+  /**
+   * Default name of the POSIX shared memory object of a ring.
+   */
+#define QUANTIS_SHM_DEFAULT_NAME "/quantis"
+
+  /**
+   * Producer of a shared memory ring. See QuantisShmCreate.
+   */
+  typedef struct QuantisShmProducer QuantisShmProducer;
+
+  /**
+   * Process side of a shared memory ring. See QuantisShmOpen.
+   */
+  typedef struct QuantisShmConsumer QuantisShmConsumer;
+
+  /**
+   * Publish random data of a device in a POSIX shared memory ring, that any
+   * process of the host can map with QuantisShmOpen.
+   *
+   * A thread fills the segments of the ring from the device. Consumers
+   * reserve bytes with atomic operations on the shared counters, as in a
+   * QuantisPool, so that they never make a system call nor touch the device
+   * while the ring holds data. Bytes are zeroed once copied out and a
+   * segment is only filled again once all its bytes were consumed, so a
+   * random byte is never returned twice.
+   *
+   * The handle must stay open, and must not be used by any other function,
+   * until the producer is destroyed.
+   * @param name the name of the shared memory object (starting with '/'),
+   * or NULL for QUANTIS_SHM_DEFAULT_NAME. An object left by a producer which
+   * is gone is replaced.
+   * @param deviceHandle a pointer to a handle the device.
+   * @param segmentSize the size (in bytes) of a segment, or 0 to use 64 KiB
+   * segments.
+   * @param segmentsCount the number of segments (2 to 4096), or 0 to use 64
+   * segments.
+   * @param producer a pointer to a pointer to the producer.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure
+   * (QUANTIS_ERROR_IO when a running producer already publishes the ring).
+   * @see QuantisShmIsActive
+   */
+  DLL_EXPORT int QuantisShmCreate(const char *name,
+                                  QuantisDeviceHandle *deviceHandle,
+                                  size_t segmentSize,
+                                  unsigned int segmentsCount,
+                                  QuantisShmProducer **producer);
+
+  /**
+   * Stop filling the ring and remove its shared memory object. Consumers get
+   * QUANTIS_ERROR_IO once they have read the remaining data.
+   * @param producer a pointer to the producer.
+   */
+  DLL_EXPORT void QuantisShmDestroy(QuantisShmProducer *producer);
+
+  /**
+   * Check whether a running producer publishes a shared memory ring.
+   * @param name the name of the shared memory object, or NULL for
+   * QUANTIS_SHM_DEFAULT_NAME.
+   * @return 1 when the ring exists and its producer is running, 0 otherwise.
+   */
+  DLL_EXPORT int QuantisShmIsActive(const char *name);
+
+  /**
+   * Map a shared memory ring published by QuantisShmCreate in this process.
+   * A consumer must not be used by several threads at the same time, each
+   * thread opens its own.
+   * @param name the name of the shared memory object, or NULL for
+   * QUANTIS_SHM_DEFAULT_NAME.
+   * @param consumer a pointer to a pointer to the consumer.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure
+   * (QUANTIS_ERROR_NO_DEVICE when there is no such ring).
+   */
+  DLL_EXPORT int QuantisShmOpen(const char *name,
+                                QuantisShmConsumer **consumer);
+
+  /**
+   * Unmap a shared memory ring.
+   * @param consumer a pointer to the consumer.
+   */
+  DLL_EXPORT void QuantisShmClose(QuantisShmConsumer *consumer);
+
+  /**
+   * Read random data from a shared memory ring, waiting for the producer
+   * when the ring is empty.
+   * @param consumer a pointer to the consumer.
+   * @param buffer a pointer to a destination buffer.
+   * @param size the number of bytes to read (not larger than QUANTIS_MAX_READ_SIZE).
+   * @return the number of read bytes on success or a QUANTIS_ERROR code on
+   * failure (QUANTIS_ERROR_IO once the producer is gone).
+   */
+  DLL_EXPORT int QuantisShmRead(QuantisShmConsumer *consumer,
+                                void *buffer,
+                                size_t size);
+
+  /**
+   * Read engine driving one or several devices from a single thread. See
+   * QuantisUringCreate.
+   */
+  typedef struct QuantisUring QuantisUring;
+
+  /**
+   * Create a read engine on top of one or more Quantis PCI devices.
+   *
+   * Up to transfersCount reads of transferSize bytes are queued at once on
+   * all the devices through io_uring, into buffers registered with the
+   * kernel, and their completions are reaped by batch: a single system call
+   * both submits new reads and collects the finished ones. Reads stay in
+   * flight between calls to QuantisUringRead.
+   *
+   * When io_uring is not available (other systems than Linux, kernels older
+   * than 5.1 or io_uring disabled) or a device is not a Quantis PCI, the
+   * engine reads the devices in turn with QuantisReadHandled instead.
+   *
+   * The handles must stay open, and must not be used by any other function,
+   * until the engine is destroyed.
+   * @param deviceHandles an array of handles on the devices.
+   * @param deviceHandlesCount the number of handles in deviceHandles.
+   * @param transferSize the size (in bytes) of a read, or 0 to use the
+   * default size.
+   * @param transfersCount the number of reads in flight (up to 1024), or 0
+   * to use the default count.
+   * @param uring a pointer to a pointer to the engine.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisUringCreate(QuantisDeviceHandle **deviceHandles,
+                                    unsigned int deviceHandlesCount,
+                                    size_t transferSize,
+                                    unsigned int transfersCount,
+                                    QuantisUring **uring);
+
+  /**
+   * Read random data from the devices of the engine. This function is not
+   * thread safe: an engine is meant to be driven by a single thread.
+   * @param uring a pointer to the engine.
+   * @param buffer a pointer to a destination buffer.
+   * @param size the number of bytes to read (not larger than QUANTIS_MAX_READ_SIZE).
+   * @return the number of read bytes on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisUringRead(QuantisUring *uring,
+                                  void *buffer,
+                                  size_t size);
+
+  /**
+   * @param uring a pointer to the engine.
+   * @return 1 when the engine reads the devices without io_uring, 0
+   * otherwise, or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisUringIsFallback(const QuantisUring *uring);
+
+  /**
+   * Cancel the reads in flight and release the engine. The devices are not
+   * closed.
+   * @param uring a pointer to the engine.
+   */
+  DLL_EXPORT void QuantisUringDestroy(QuantisUring *uring);
+
+  /**
+   * Set how the prefetch buffers and pools created from now on are allocated.
+   * Hugepages reduce TLB misses when copying out of buffers of several MiB.
+   * Reserved hugepages must have been set up by the administrator
+   * (vm.nr_hugepages); transparent hugepages are used when none is free.
+   * @param mode the memory mode.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   * QUANTIS_ERROR_OPERATION_NOT_SUPPORTED is returned for hugepages on
+   * systems other than Linux.
+   */
+  DLL_EXPORT int QuantisSetMemoryMode(QuantisMemoryMode mode);
+
+  /**
+   * @return the memory mode set by QuantisSetMemoryMode.
+   */
+  DLL_EXPORT QuantisMemoryMode QuantisGetMemoryMode();
+
+  /**
+   * @return the number of NUMA nodes of the system, 1 when the system has no
+   * NUMA support.
+   */
+  DLL_EXPORT int QuantisGetNumaNodesCount();
+
+  /**
+   * Get the NUMA node nearest to the device, from the bus and device numbers
+   * of the card and the locality reported by sysfs. Prefetch threads and
+   * pools are placed on this node.
+   * @param deviceHandle a pointer to a handle the device
+   * @return the node of the device, or -1 when it is unknown (USB devices,
+   * simulator, single node systems or systems other than Linux).
+   */
+  DLL_EXPORT int QuantisGetNumaNode(QuantisDeviceHandle *deviceHandle);
+
+  /**
+   * @return the NUMA node the calling thread is currently running on, or -1
+   * when it is unknown.
+   */
+  DLL_EXPORT int QuantisGetCurrentNumaNode();
+
+  /**
+   * Restrict the calling thread to the CPUs of a NUMA node.
+   * @param numaNode the node.
+   * @return QUANTIS_SUCCESS on success or a QUANTIS_ERROR code on failure.
+   */
+  DLL_EXPORT int QuantisBindThreadToNumaNode(int numaNode);
+
   /**
    * Get a pointer to the error message string.
    *